@@ -0,0 +1,532 @@
+#include "wave_solver_cpu.h"
+
+#ifdef WAVE_HEADLESS_EGL
+#include "headless_context.h"
+#include "camera.h"
+#include "shader.h"
+#endif
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <type_traits>
+
+namespace
+{
+   const std::vector<std::string> KnownBackends{
+      "cpu-scalar", "cpu-simd", "cpu-threaded", "gpu-global", "gpu-tiled", "gpu-draw"
+   };
+   // a group of WAVE_GROUP_SIZE x WAVE_GROUP_SIZE invocations must not exceed the 1024 which every GL 4.3 device has.
+   constexpr int MaxGroupSize = 32;
+   // gpu-draw draws into a framebuffer of the default window size of the app.
+   constexpr int DrawFrameWidth = 1920;
+   constexpr int DrawFrameHeight = 1080;
+
+   struct BenchOptions
+   {
+      std::vector<int> PointNums{ 128, 256, 512, 1024, 2048, 4096, 8192 };
+      std::vector<std::string> Backends = KnownBackends;
+      std::vector<int> ThreadNums;
+      std::vector<int> GroupSizes{ 8, 16, 32 };
+      int StepNum = 100;
+      int DrawFrameNum = 10;
+      int BlockStepNum = 1;
+      bool PinThreads = false;
+      std::string JsonPath;
+   };
+
+   // one backend configuration on one grid. the CPU fills ThreadNum and the GPU fills GroupSize.
+   // Speedup is relative to the 1-thread cpu-threaded row on the same grid, and 0 for the other backends.
+   struct BenchResult
+   {
+      std::string Backend;
+      std::string Kernel;
+      int PointNum;
+      int ThreadNum;
+      int GroupSize;
+      double StepSeconds;
+      double NormalSeconds;
+      int NormalBytesPerPoint;
+      double Speedup;
+   };
+
+   // one way of drawing the vertex pulling surface on one grid. the frame time includes the GPU work.
+   struct DrawResult
+   {
+      std::string Mode;
+      int PointNum;
+      int CallNum;
+      double SubmitSeconds;
+      double FrameSeconds;
+   };
+
+   // the least memory traffic of a pass. a step reads two levels and writes one, and a normal pass reads the
+   // heights it differentiates and writes a normal. GB/s well below the hardware bandwidth means time goes elsewhere.
+   constexpr int StepBytesPerPoint = 3 * sizeof( float );
+   constexpr int CPUNormalBytesPerPoint = sizeof( float ) + sizeof( glm::vec3 );
+   // the GPU pass blends the previous level in and writes the height next to the normal.
+   constexpr int GPUNormalBytesPerPoint = 2 * sizeof( float ) + sizeof( glm::vec4 );
+
+   void printUsage()
+   {
+      std::cout << "Usage: WaveBench [--sizes N,...] [--backends B,...] [--threads T,...] [--group-sizes G,...]\n"
+         << "                 [--steps S] [--block-steps K] [--frames F] [--pin] [--json FILE]\n"
+         << "  backends: cpu-scalar, cpu-simd, cpu-threaded, gpu-global, gpu-tiled, gpu-draw\n"
+         << "  gpu-draw draws F frames of the surface once per grid row and once with primitive restart.\n"
+         << "  cpu-threaded always runs 1 thread too, and reports speedup and efficiency against it.\n"
+         << "  without --json, the JSON report is written to the standard output instead of a table.\n";
+   }
+
+   template<typename T>
+   std::vector<T> parseList(const std::string& list)
+   {
+      std::vector<T> values;
+      std::istringstream stream( list );
+      std::string value;
+      while (std::getline( stream, value, ',' )) {
+         if constexpr (std::is_same_v<T, int>) values.emplace_back( std::stoi( value ) );
+         else values.emplace_back( value );
+      }
+      return values;
+   }
+
+   bool parseOptions(BenchOptions& options, int argc, char** argv)
+   {
+      for (int i = 1; i < argc; ++i) {
+         const std::string option = argv[i];
+         const bool has_value = i + 1 < argc;
+         if (option == "--sizes" && has_value) options.PointNums = parseList<int>( argv[++i] );
+         else if (option == "--backends" && has_value) options.Backends = parseList<std::string>( argv[++i] );
+         else if (option == "--threads" && has_value) options.ThreadNums = parseList<int>( argv[++i] );
+         else if (option == "--group-sizes" && has_value) options.GroupSizes = parseList<int>( argv[++i] );
+         else if (option == "--steps" && has_value) options.StepNum = std::stoi( argv[++i] );
+         else if (option == "--block-steps" && has_value) options.BlockStepNum = std::stoi( argv[++i] );
+         else if (option == "--frames" && has_value) options.DrawFrameNum = std::stoi( argv[++i] );
+         else if (option == "--json" && has_value) options.JsonPath = argv[++i];
+         else if (option == "--pin") options.PinThreads = true;
+         else return false;
+      }
+      if (options.ThreadNums.empty()) {
+         const int max_thread_num = ThreadPool::getHardwareThreadNum();
+         for (int thread_num = 1; thread_num < max_thread_num; thread_num *= 2) {
+            options.ThreadNums.emplace_back( thread_num );
+         }
+         options.ThreadNums.emplace_back( max_thread_num );
+      }
+      // the speedup and efficiency of cpu-threaded are measured against its 1-thread run.
+      if (std::find( options.ThreadNums.begin(), options.ThreadNums.end(), 1 ) == options.ThreadNums.end()) {
+         options.ThreadNums.insert( options.ThreadNums.begin(), 1 );
+      }
+      const auto known = [](const std::string& backend) {
+         return std::find( KnownBackends.begin(), KnownBackends.end(), backend ) != KnownBackends.end();
+      };
+      return options.StepNum > 0 && options.DrawFrameNum > 0 && !options.PointNums.empty() &&
+         std::all_of( options.Backends.begin(), options.Backends.end(), known ) &&
+         std::all_of( options.PointNums.begin(), options.PointNums.end(), [](int size) { return size > 1; } ) &&
+         std::all_of( options.ThreadNums.begin(), options.ThreadNums.end(), [](int num) { return num > 0; } ) &&
+         std::all_of(
+            options.GroupSizes.begin(), options.GroupSizes.end(),
+            [](int size) { return size > 0 && size <= MaxGroupSize; }
+         );
+   }
+
+   template<typename Pass>
+   double getSecondsPerPass(const Pass& pass, int pass_num)
+   {
+      pass( 1 );
+      const auto start = std::chrono::steady_clock::now();
+      pass( pass_num );
+      const auto end = std::chrono::steady_clock::now();
+      return std::chrono::duration<double>(end - start).count() / static_cast<double>(pass_num);
+   }
+
+   BenchResult runCPU(const std::string& backend, int point_num, int thread_num, const BenchOptions& options)
+   {
+      const bool threaded = backend == "cpu-threaded";
+      WaveSolverCPU solver;
+      solver.setKernelISA( backend == "cpu-scalar" ? WaveKernelISA::Scalar : getBestSupportedWaveKernelISA() );
+      solver.setThreadNum( threaded ? thread_num : 1, options.PinThreads );
+      solver.setTemporalBlocking( threaded ? options.BlockStepNum : 1 );
+      solver.initialize( glm::ivec2(point_num, point_num), glm::ivec2(5, 5) );
+
+      BenchResult result{
+         backend, getWaveKernelISAString( solver.getKernelISA() ), point_num, solver.getThreadNum(), 0, 0.0, 0.0,
+         CPUNormalBytesPerPoint, 0.0
+      };
+      // the step is the height update alone like the GPU step kernel, and the normal pass is timed on its own.
+      result.StepSeconds = getSecondsPerPass( [&solver](int step_num) { solver.advance( step_num ); }, options.StepNum );
+      result.NormalSeconds = getSecondsPerPass(
+         [&solver](int pass_num) { for (int i = 0; i < pass_num; ++i) solver.estimateNormals(); }, options.StepNum
+      );
+      return result;
+   }
+
+#ifdef WAVE_HEADLESS_EGL
+   // the same dispatches as RendererGL::stepWave and estimateWaveSurface in the vertex pulling mode.
+   BenchResult runGPU(const std::string& backend, int point_num, int group_size, const BenchOptions& options)
+   {
+      const std::string shader_directory_path = std::string(CMAKE_SOURCE_DIR) + "/shaders";
+      const std::string group_size_define = "WAVE_GROUP_SIZE " + std::to_string( group_size );
+      const std::string step_shader_path =
+         shader_directory_path + (backend == "gpu-tiled" ? "/wave_tiled.comp" : "/wave.comp");
+      ShaderGL step_shader;
+      step_shader.setComputeShaders( step_shader_path.c_str(), { group_size_define } );
+      step_shader.setWaveUniformLocations();
+      ShaderGL normal_shader;
+      normal_shader.setComputeShaders(
+         std::string(shader_directory_path + "/wave_normal.comp").c_str(),
+         { group_size_define, "WAVE_VERTEX_PULLING" }
+      );
+      normal_shader.setWaveNormalUniformLocations();
+
+      const glm::ivec2 wave_point_num_size(point_num, point_num);
+      const glm::vec2 grid_step = WaveSolverCPU::getWaveGridStep( wave_point_num_size, glm::ivec2(5, 5) );
+      const auto point_total = static_cast<size_t>(point_num) * point_num;
+      std::vector<float> heights(point_total);
+      for (int j = 0; j < point_num; ++j) {
+         for (int i = 0; i < point_num; ++i) {
+            heights[j * point_num + i] = WaveSolverCPU::getInitialHeight( wave_point_num_size, i, j );
+         }
+      }
+
+      std::array<GLuint, 4> buffers{};
+      glCreateBuffers( 4, buffers.data() );
+      for (int i = 0; i < 3; ++i) {
+         glNamedBufferStorage(
+            buffers[i], static_cast<GLsizeiptr>(point_total * sizeof( float )), heights.data(), GL_DYNAMIC_STORAGE_BIT
+         );
+      }
+      glNamedBufferStorage( buffers[3], static_cast<GLsizeiptr>(point_total * sizeof( glm::vec4 )), nullptr, 0 );
+
+      const auto group_num = static_cast<GLuint>((point_num + group_size - 1) / group_size);
+      int target_index = 0;
+      const auto step = [&](int step_num) {
+         glUseProgram( step_shader.getShaderProgram() );
+         glUniform1f( step_shader.getLocation( ShaderGL::Uniform::WaveFactor ), WaveSolverCPU::getWaveFactor( grid_step.x ) );
+         glUniform2iv( step_shader.getLocation( ShaderGL::Uniform::WavePointNumSize ), 1, &wave_point_num_size[0] );
+         for (int s = 0; s < step_num; ++s) {
+            for (int i = 0; i < 3; ++i) {
+               glBindBufferBase( GL_SHADER_STORAGE_BUFFER, i, buffers[(target_index + i) % 3] );
+            }
+            glDispatchCompute( group_num, group_num, 1 );
+            glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+            target_index = (target_index + 1) % 3;
+         }
+         glFinish();
+      };
+      const auto estimate_normals = [&](int pass_num) {
+         glUseProgram( normal_shader.getShaderProgram() );
+         glUniform2iv( normal_shader.getLocation( ShaderGL::Uniform::WavePointNumSize ), 1, &wave_point_num_size[0] );
+         glUniform2fv( normal_shader.getLocation( ShaderGL::Uniform::WaveGridStep ), 1, &grid_step[0] );
+         glUniform1f( normal_shader.getLocation( ShaderGL::Uniform::WaveLevelBlend ), 1.0f );
+         glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, buffers[(target_index + 1) % 3] );
+         glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, buffers[3] );
+         glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, buffers[target_index] );
+         for (int i = 0; i < pass_num; ++i) {
+            glDispatchCompute( group_num, group_num, 1 );
+            glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+         }
+         glFinish();
+      };
+
+      BenchResult result{
+         backend, backend.substr( 4 ), point_num, 0, group_size, 0.0, 0.0, GPUNormalBytesPerPoint, 0.0
+      };
+      result.StepSeconds = getSecondsPerPass( step, options.StepNum );
+      result.NormalSeconds = getSecondsPerPass( estimate_normals, options.StepNum );
+      glDeleteBuffers( 4, buffers.data() );
+      return result;
+   }
+
+   // the draw of RendererGL::drawWaveObject in the vertex pulling mode, with the per-row calls which the r key
+   // switches to in the app. the surface is the first step of the CPU solver, and the scene has no light.
+   std::vector<DrawResult> runDraw(int point_num, const BenchOptions& options)
+   {
+      const std::string shader_directory_path = std::string(CMAKE_SOURCE_DIR) + "/shaders";
+      ShaderGL draw_shader;
+      draw_shader.setShader(
+         std::string(shader_directory_path + "/wave.vert").c_str(),
+         std::string(shader_directory_path + "/screen.frag").c_str()
+      );
+      draw_shader.setWaveSceneUniformLocations();
+
+      const glm::ivec2 wave_point_num_size(point_num, point_num);
+      WaveSolverCPU solver;
+      solver.initialize( wave_point_num_size, glm::ivec2(5, 5) );
+      solver.step();
+      const auto point_total = static_cast<size_t>(point_num) * point_num;
+      std::vector<glm::vec4> height_normals(point_total);
+      for (size_t i = 0; i < point_total; ++i) {
+         height_normals[i] = glm::vec4(solver.getCurrentHeights()[i], solver.getNormals()[i]);
+      }
+
+      // the strips of ObjectGL::setWaveObject. GL_PRIMITIVE_RESTART_FIXED_INDEX treats the largest index as the restart.
+      std::vector<GLuint> indices;
+      for (int j = 0; j < point_num - 1; ++j) {
+         if (j > 0) indices.emplace_back( 0xFFFFFFFFu );
+         for (int i = 0; i < point_num; ++i) {
+            indices.emplace_back( (j + 1) * point_num + i );
+            indices.emplace_back( j * point_num + i );
+         }
+      }
+
+      // the material and the lights are left zero, which leaves out the lighting but not the fragments.
+      GLint material_block_size = 0, light_block_size = 0;
+      const GLuint program = draw_shader.getShaderProgram();
+      glGetActiveUniformBlockiv(
+         program, glGetUniformBlockIndex( program, "MaterialBlock" ), GL_UNIFORM_BLOCK_DATA_SIZE, &material_block_size
+      );
+      glGetActiveUniformBlockiv(
+         program, glGetUniformBlockIndex( program, "LightBlock" ), GL_UNIFORM_BLOCK_DATA_SIZE, &light_block_size
+      );
+      const std::vector<char> zeros(static_cast<size_t>(std::max( material_block_size, light_block_size )), 0);
+
+      std::array<GLuint, 4> buffers{};
+      glCreateBuffers( 4, buffers.data() );
+      glNamedBufferStorage(
+         buffers[0], static_cast<GLsizeiptr>(height_normals.size() * sizeof( glm::vec4 )), height_normals.data(), 0
+      );
+      glNamedBufferStorage( buffers[1], static_cast<GLsizeiptr>(indices.size() * sizeof( GLuint )), indices.data(), 0 );
+      glNamedBufferStorage( buffers[2], material_block_size, zeros.data(), 0 );
+      glNamedBufferStorage( buffers[3], light_block_size, zeros.data(), 0 );
+      GLuint vao = 0;
+      glCreateVertexArrays( 1, &vao );
+      glVertexArrayElementBuffer( vao, buffers[1] );
+
+      CameraGL camera;
+      camera.updateWindowSize( DrawFrameWidth, DrawFrameHeight );
+      camera.transferCameraBuffer( glm::mat4(1.0f) );
+      const glm::vec2 grid_step = solver.getWaveGridStep();
+      glUseProgram( program );
+      glUniform2iv( draw_shader.getLocation( ShaderGL::Uniform::WavePointNumSize ), 1, &wave_point_num_size[0] );
+      glUniform2fv( draw_shader.getLocation( ShaderGL::Uniform::WaveGridStep ), 1, &grid_step[0] );
+      glUniform1i( draw_shader.getLocation( ShaderGL::Uniform::UseTexture ), 0 );
+      glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, buffers[0] );
+      glBindBufferBase( GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, buffers[2] );
+      glBindBufferBase( GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, buffers[3] );
+      glBindVertexArray( vao );
+      glEnable( GL_DEPTH_TEST );
+      glEnable( GL_PRIMITIVE_RESTART_FIXED_INDEX );
+
+      const int row_index_num = point_num * 2;
+      std::vector<DrawResult> results;
+      for (const bool single_call : { false, true }) {
+         double submit_seconds = 0.0;
+         const auto draw = [&](int frame_num) {
+            for (int frame = 0; frame < frame_num; ++frame) {
+               glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+               const auto submit_start = std::chrono::steady_clock::now();
+               if (single_call) {
+                  glDrawElements( GL_TRIANGLE_STRIP, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr );
+               }
+               else {
+                  for (int j = 0; j < point_num - 1; ++j) {
+                     glDrawElements(
+                        GL_TRIANGLE_STRIP, row_index_num, GL_UNSIGNED_INT,
+                        reinterpret_cast<GLvoid*>(j * (row_index_num + 1) * sizeof( GLuint ))
+                     );
+                  }
+               }
+               submit_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - submit_start).count();
+            }
+            glFinish();
+         };
+         draw( 1 );
+         submit_seconds = 0.0;
+         const auto start = std::chrono::steady_clock::now();
+         draw( options.DrawFrameNum );
+         const auto end = std::chrono::steady_clock::now();
+         const auto frame_num = static_cast<double>(options.DrawFrameNum);
+         results.push_back(
+            {
+               single_call ? "single" : "rows", point_num, single_call ? 1 : point_num - 1, submit_seconds / frame_num,
+               std::chrono::duration<double>(end - start).count() / frame_num
+            }
+         );
+      }
+
+      glDisable( GL_PRIMITIVE_RESTART_FIXED_INDEX );
+      glDisable( GL_DEPTH_TEST );
+      glBindVertexArray( 0 );
+      glUseProgram( 0 );
+      glDeleteVertexArrays( 1, &vao );
+      glDeleteBuffers( 4, buffers.data() );
+      return results;
+   }
+#endif
+
+   double getGigabytesPerSecond(int point_num, int bytes_per_point, double seconds)
+   {
+      return static_cast<double>(point_num) * point_num * bytes_per_point / seconds * 1e-9;
+   }
+
+   void writeJson(
+      std::ostream& out,
+      const std::vector<BenchResult>& results,
+      const std::vector<DrawResult>& draw_results,
+      const std::string& renderer,
+      int step_num
+   )
+   {
+      out << std::fixed << std::setprecision( 6 );
+      out << "{\n";
+      out << "  \"steps\": " << step_num << ",\n";
+      out << "  \"hardware_threads\": " << ThreadPool::getHardwareThreadNum() << ",\n";
+      out << "  \"gpu_renderer\": \"" << renderer << "\",\n";
+      out << "  \"results\": [\n";
+      for (size_t i = 0; i < results.size(); ++i) {
+         const BenchResult& result = results[i];
+         out << "    { \"backend\": \"" << result.Backend << "\", \"kernel\": \"" << result.Kernel << "\""
+            << ", \"size\": " << result.PointNum
+            << ", \"threads\": " << result.ThreadNum
+            << ", \"group_size\": " << result.GroupSize
+            << ", \"steps_per_second\": " << 1.0 / result.StepSeconds
+            << ", \"step_ms\": " << result.StepSeconds * 1000.0
+            << ", \"normal_ms\": " << result.NormalSeconds * 1000.0
+            << ", \"step_gbps\": " << getGigabytesPerSecond( result.PointNum, StepBytesPerPoint, result.StepSeconds )
+            << ", \"normal_gbps\": "
+            << getGigabytesPerSecond( result.PointNum, result.NormalBytesPerPoint, result.NormalSeconds );
+         if (result.Speedup > 0.0) {
+            out << ", \"speedup\": " << result.Speedup
+               << ", \"efficiency\": " << result.Speedup / static_cast<double>(result.ThreadNum);
+         }
+         else out << ", \"speedup\": null, \"efficiency\": null";
+         out << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+      }
+      out << "  ],\n";
+      out << "  \"draws\": [\n";
+      for (size_t i = 0; i < draw_results.size(); ++i) {
+         const DrawResult& result = draw_results[i];
+         out << "    { \"mode\": \"" << result.Mode << "\""
+            << ", \"size\": " << result.PointNum
+            << ", \"draw_calls\": " << result.CallNum
+            << ", \"submit_ms\": " << result.SubmitSeconds * 1000.0
+            << ", \"frame_ms\": " << result.FrameSeconds * 1000.0
+            << " }" << (i + 1 < draw_results.size() ? ",\n" : "\n");
+      }
+      out << "  ]\n";
+      out << "}\n";
+   }
+
+   void printDrawResults(const std::vector<DrawResult>& draw_results)
+   {
+      if (draw_results.empty()) return;
+
+      std::cout << "\nDraws into " << DrawFrameWidth << "x" << DrawFrameHeight << "\n";
+      std::cout << std::setw( 8 ) << "mode" << std::setw( 7 ) << "size" << std::setw( 8 ) << "calls"
+         << std::setw( 11 ) << "submit ms" << std::setw( 11 ) << "frame ms\n";
+      for (const auto& result : draw_results) {
+         std::cout << std::fixed << std::setprecision( 3 )
+            << std::setw( 8 ) << result.Mode
+            << std::setw( 7 ) << result.PointNum
+            << std::setw( 8 ) << result.CallNum
+            << std::setw( 11 ) << result.SubmitSeconds * 1000.0
+            << std::setw( 11 ) << result.FrameSeconds * 1000.0 << "\n";
+      }
+   }
+
+   void printResult(const BenchResult& result)
+   {
+      std::cout << std::fixed << std::setprecision( 3 )
+         << std::setw( 14 ) << result.Backend
+         << std::setw( 8 ) << result.Kernel
+         << std::setw( 7 ) << result.PointNum
+         << std::setw( 9 ) << (result.GroupSize > 0 ? result.GroupSize : result.ThreadNum)
+         << std::setw( 12 ) << 1.0 / result.StepSeconds
+         << std::setw( 11 ) << result.StepSeconds * 1000.0
+         << std::setw( 11 ) << result.NormalSeconds * 1000.0
+         << std::setw( 11 ) << getGigabytesPerSecond( result.PointNum, StepBytesPerPoint, result.StepSeconds )
+         << std::setw( 11 )
+         << getGigabytesPerSecond( result.PointNum, result.NormalBytesPerPoint, result.NormalSeconds );
+      if (result.Speedup > 0.0) {
+         std::cout << std::setw( 9 ) << result.Speedup
+            << std::setw( 8 ) << result.Speedup / static_cast<double>(result.ThreadNum) * 100.0 << "%\n";
+      }
+      else std::cout << std::setw( 9 ) << "-" << std::setw( 9 ) << "-" << "\n";
+   }
+}
+
+int main(int argc, char** argv)
+{
+   BenchOptions options;
+   if (!parseOptions( options, argc, argv )) {
+      printUsage();
+      return 1;
+   }
+
+   const bool gpu_requested = std::any_of(
+      options.Backends.begin(), options.Backends.end(),
+      [](const std::string& backend) { return backend.rfind( "gpu-", 0 ) == 0; }
+   );
+   std::string renderer = "none";
+#ifdef WAVE_HEADLESS_EGL
+   HeadlessContextGL context;
+   const bool gpu_available = gpu_requested && context.initialize( DrawFrameWidth, DrawFrameHeight );
+   if (gpu_available) renderer = reinterpret_cast<const char*>(glGetString( GL_RENDERER ));
+#else
+   const bool gpu_available = false;
+#endif
+   if (gpu_requested && !gpu_available) std::cerr << "No headless OpenGL context, skipping the GPU backends\n";
+
+   const bool table = !options.JsonPath.empty();
+   if (table) {
+      std::cout << "GPU: " << renderer << ", " << options.StepNum << " steps\n";
+      std::cout << std::setw( 14 ) << "backend" << std::setw( 8 ) << "kernel" << std::setw( 7 ) << "size"
+         << std::setw( 9 ) << "thr/grp" << std::setw( 12 ) << "steps/s" << std::setw( 11 ) << "step ms"
+         << std::setw( 11 ) << "normal ms" << std::setw( 11 ) << "step GB/s" << std::setw( 11 ) << "norm GB/s"
+         << std::setw( 9 ) << "speedup" << std::setw( 9 ) << "eff\n";
+   }
+
+   std::vector<BenchResult> results;
+   std::vector<DrawResult> draw_results;
+   const auto add_result = [&](const BenchResult& result) {
+      results.emplace_back( result );
+      if (table) printResult( result );
+   };
+   for (const auto point_num : options.PointNums) {
+      for (const auto& backend : options.Backends) {
+         if (backend == "cpu-scalar" || backend == "cpu-simd") add_result( runCPU( backend, point_num, 1, options ) );
+         else if (backend == "cpu-threaded") {
+            std::vector<BenchResult> threaded_results;
+            for (const auto thread_num : options.ThreadNums) {
+               threaded_results.emplace_back( runCPU( backend, point_num, thread_num, options ) );
+            }
+            const auto single_thread = std::find_if(
+               threaded_results.begin(), threaded_results.end(),
+               [](const BenchResult& result) { return result.ThreadNum == 1; }
+            );
+            for (auto& result : threaded_results) {
+               result.Speedup = single_thread->StepSeconds / result.StepSeconds;
+               add_result( result );
+            }
+         }
+         else if (gpu_available) {
+#ifdef WAVE_HEADLESS_EGL
+            if (backend == "gpu-draw") {
+               const std::vector<DrawResult> draws = runDraw( point_num, options );
+               draw_results.insert( draw_results.end(), draws.begin(), draws.end() );
+               continue;
+            }
+            for (const auto group_size : options.GroupSizes) {
+               add_result( runGPU( backend, point_num, group_size, options ) );
+            }
+#endif
+         }
+      }
+   }
+
+   if (table) {
+      printDrawResults( draw_results );
+      std::ofstream file( options.JsonPath );
+      if (!file.is_open()) {
+         std::cerr << "Cannot open " << options.JsonPath << "\n";
+         return 1;
+      }
+      writeJson( file, results, draw_results, renderer, options.StepNum );
+   }
+   else writeJson( std::cout, results, draw_results, renderer, options.StepNum );
+   return 0;
+}
\ No newline at end of file
@@ -13,14 +13,23 @@
 
 #include <FreeImage.h>
 #include <iostream>
+#include <algorithm>
 #include <iomanip>
 #include <vector>
 #include <string>
+#include <cstring>
 #include <map>
 #include <unordered_map>
 #include <sstream>
 #include <fstream>
+#include <filesystem>
 #include <chrono>
+#include <memory>
+#include <array>
+#include <cassert>
+#include <thread>
+#include <mutex>
+#include <atomic>
 
 #include "project_constants.h"
 
@@ -29,4 +38,9 @@ using uint = unsigned int;
 
 constexpr uint OPENGL_COLOR_BUFFER_BIT = 0x00004000u;
 constexpr uint OPENGL_DEPTH_BUFFER_BIT = 0x00000100u;
-constexpr uint OPENGL_STENCIL_BUFFER_BIT = 0x00000400u;
\ No newline at end of file
+constexpr uint OPENGL_STENCIL_BUFFER_BIT = 0x00000400u;
+
+// the binding points of the std140 uniform blocks which the scene shaders share.
+constexpr GLuint CAMERA_BLOCK_BINDING = 0;
+constexpr GLuint MATERIAL_BLOCK_BINDING = 1;
+constexpr GLuint LIGHT_BLOCK_BINDING = 2;
\ No newline at end of file
@@ -14,6 +14,12 @@ public:
       float near_plane = 0.1f,
       float far_plane = 10000.0f
    );
+   ~CameraGL();
+
+   CameraGL(const CameraGL&) = delete;
+   CameraGL(const CameraGL&&) = delete;
+   CameraGL& operator=(const CameraGL&) = delete;
+   CameraGL& operator=(const CameraGL&&) = delete;
 
    [[nodiscard]] bool getMovingState() const { return IsMoving; }
    [[nodiscard]] glm::vec3 getCameraPosition() const { return CamPos; }
@@ -34,9 +40,13 @@ public:
    void zoomOut();
    void resetCamera();
    void updateWindowSize(int width, int height);
+   // uploads the matrices only when the camera or to_world has changed since the last call.
+   void transferCameraBuffer(const glm::mat4& to_world);
 
 private:
    bool IsMoving;
+   bool CameraBufferDirty;
+   GLuint CameraBuffer;
    int Width;
    int Height;
    float FOV;
@@ -53,4 +63,5 @@ private:
    glm::vec3 CamPos;
    glm::mat4 ViewMatrix;
    glm::mat4 ProjectionMatrix;
+   glm::mat4 CameraBufferWorldMatrix;
 };
\ No newline at end of file
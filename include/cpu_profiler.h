@@ -0,0 +1,102 @@
+#pragma once
+
+#include "base.h"
+
+// Records how long scoped zones of CPU code take, so that event polling, uniform uploads, buffer rotation and the
+// swap can be seen side by side in chrome://tracing or Perfetto.
+// Every thread writes the zones it closes into a ring of its own, which takes no lock once the thread has one.
+// A ring keeps the last RingZoneNum zones of its thread, so an export covers the most recent frames only.
+// A thread only gets a ring when it records its first zone. The ring is released when the thread exits,
+// and the next thread of the same name takes it over, so restarted threads do not pile up rings.
+class CPUProfiler final
+{
+public:
+   CPUProfiler() = delete;
+
+   static void setEnabled(bool enabled) { Enabled.store( enabled, std::memory_order_relaxed ); }
+   // the name is kept until the thread records its first zone. it has to be a string literal.
+   static void setThreadName(const char* thread_name);
+   static void beginFrame() { FrameIndex.fetch_add( 1, std::memory_order_relaxed ); }
+   [[nodiscard]] static bool isEnabled() { return Enabled.load( std::memory_order_relaxed ); }
+   [[nodiscard]] static int64_t getFrameIndex() { return FrameIndex.load( std::memory_order_relaxed ); }
+   // the zones which began between first_frame and last_frame. the zones before the first frame have frame 0.
+   [[nodiscard]] static bool exportChromeTrace(const std::string& file_path, int64_t first_frame, int64_t last_frame);
+
+private:
+   friend class CPUZone;
+
+   struct Zone
+   {
+      const char* Name;
+      int64_t Frame;
+      int64_t BeginTime;
+      int64_t EndTime;
+   };
+
+   // the fields are atomic, so an export can read a slot while its thread overwrites it.
+   struct ZoneSlot
+   {
+      std::atomic<const char*> Name;
+      std::atomic<int64_t> Frame;
+      std::atomic<int64_t> BeginTime;
+      std::atomic<int64_t> EndTime;
+   };
+
+   // StartedZoneNum counts the zones whose slot is being written or is written, and ZoneNum the written ones.
+   // the two work as a sequence lock: a slot read by an export is only kept if no write to it has started since.
+   struct ThreadRing
+   {
+      const char* ThreadName;
+      bool Owned;
+      std::unique_ptr<ZoneSlot[]> Zones;
+      std::atomic<uint64_t> StartedZoneNum;
+      std::atomic<uint64_t> ZoneNum;
+   };
+
+   // releases the ring of a thread when the thread exits.
+   struct ThreadRingOwner
+   {
+      ThreadRing* Ring = nullptr;
+      const char* ThreadName = nullptr;
+      ~ThreadRingOwner();
+   };
+
+   static constexpr uint64_t RingZoneNum = 1 << 16;
+
+   inline static std::atomic<bool> Enabled{ false };
+   inline static std::atomic<int64_t> FrameIndex{ 0 };
+   inline static std::mutex RingLock;
+   inline static std::vector<std::unique_ptr<ThreadRing>> Rings;
+   inline static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
+   // nanoseconds since the start of the program.
+   [[nodiscard]] static int64_t getTime()
+   {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count();
+   }
+   [[nodiscard]] static ThreadRingOwner& getThreadRingOwner();
+   [[nodiscard]] static ThreadRing* getThreadRing();
+   static void record(const char* name, int64_t frame, int64_t begin_time);
+};
+
+// times the scope it lives in as a zone of the frame it began in. the name has to be a string literal,
+// because only the pointer is kept. nothing is read or recorded while the profiler is disabled.
+class CPUZone final
+{
+public:
+   explicit CPUZone(const char* name) :
+      Name( CPUProfiler::isEnabled() ? name : nullptr ),
+      Frame( Name != nullptr ? CPUProfiler::getFrameIndex() : 0 ),
+      BeginTime( Name != nullptr ? CPUProfiler::getTime() : 0 ) {}
+   ~CPUZone() { if (Name != nullptr) CPUProfiler::record( Name, Frame, BeginTime ); }
+
+   CPUZone(const CPUZone&) = delete;
+   CPUZone(const CPUZone&&) = delete;
+   CPUZone& operator=(const CPUZone&) = delete;
+   CPUZone& operator=(const CPUZone&&) = delete;
+
+private:
+   const char* Name;
+   int64_t Frame;
+   int64_t BeginTime;
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "base.h"
+
+// Times the passes of a frame on the GPU with a pair of timestamp queries per pass.
+// The queries of a frame stay in a ring of FrameLatency slots and are read only when their slot comes round again.
+// By then the GPU has long finished them, so the reading never stalls. A frame still pending then is skipped,
+// and its CSV row has empty columns. flush() waits for the frames in flight, so that the last ones are kept too.
+// A pass which a frame did not run adds nothing to its average and leaves its CSV column empty.
+class GPUTimerGL final
+{
+public:
+   explicit GPUTimerGL(std::vector<std::string> pass_names, int frame_latency = 4);
+   ~GPUTimerGL();
+
+   GPUTimerGL(const GPUTimerGL&) = delete;
+   GPUTimerGL(const GPUTimerGL&&) = delete;
+   GPUTimerGL& operator=(const GPUTimerGL&) = delete;
+   GPUTimerGL& operator=(const GPUTimerGL&&) = delete;
+
+   void setEnabled(bool enabled);
+   [[nodiscard]] bool setCSVFile(const std::string& file_path);
+   void beginFrame();
+   void begin(int pass);
+   void end(int pass);
+   void flush();
+   [[nodiscard]] bool isEnabled() const { return Enabled; }
+   [[nodiscard]] int getSkippedFrameNum() const { return SkippedFrameNum; }
+   [[nodiscard]] double getAverageTime(int pass) const;
+   [[nodiscard]] std::string getAverageTimeString() const;
+
+private:
+   struct FrameSlot
+   {
+      int64_t FrameIndex;
+      std::vector<std::array<GLuint, 2>> Queries;
+      std::vector<bool> Issued;
+   };
+
+   // the averages are taken over this many of the last frames which ran a pass.
+   static constexpr int AverageFrameNum = 60;
+
+   bool Enabled;
+   int64_t FrameIndex;
+   int SkippedFrameNum;
+   std::vector<std::string> PassNames;
+   std::vector<FrameSlot> Slots;
+   std::vector<std::array<double, AverageFrameNum>> PassTimes;
+   std::vector<int> PassTimeNums;
+   std::ofstream CSVFile;
+
+   [[nodiscard]] FrameSlot& getCurrentSlot() { return Slots[FrameIndex % static_cast<int64_t>(Slots.size())]; }
+   void collect(FrameSlot& slot, bool wait);
+};
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "base.h"
+
+#ifdef WAVE_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+// An OpenGL context which needs no display, for batch jobs and render farms.
+// It is a surfaceless EGL context, which Mesa llvmpipe provides without a GPU, so the frames are drawn into
+// a framebuffer object instead of a window. Builds without EGL cannot initialize it.
+class HeadlessContextGL final
+{
+public:
+   HeadlessContextGL();
+   ~HeadlessContextGL();
+
+   HeadlessContextGL(const HeadlessContextGL&) = delete;
+   HeadlessContextGL(const HeadlessContextGL&&) = delete;
+   HeadlessContextGL& operator=(const HeadlessContextGL&) = delete;
+   HeadlessContextGL& operator=(const HeadlessContextGL&&) = delete;
+
+   [[nodiscard]] bool initialize(int width, int height);
+   [[nodiscard]] GLuint getFBO() const { return FBO; }
+   [[nodiscard]] int getWidth() const { return Width; }
+   [[nodiscard]] int getHeight() const { return Height; }
+
+private:
+   int Width;
+   int Height;
+   GLuint FBO;
+   GLuint ColorBuffer;
+   GLuint DepthBuffer;
+#ifdef WAVE_HEADLESS_EGL
+   EGLDisplay Display;
+   EGLContext Context;
+#endif
+};
\ No newline at end of file
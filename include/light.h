@@ -5,8 +5,16 @@
 class LightGL final
 {
 public:
+   // MAX_LIGHTS of screen.frag. lights added beyond it are kept but not drawn.
+   static constexpr int MaxLightNum = 32;
+
    LightGL();
-   ~LightGL() = default;
+   ~LightGL();
+
+   LightGL(const LightGL&) = delete;
+   LightGL(const LightGL&&) = delete;
+   LightGL& operator=(const LightGL&) = delete;
+   LightGL& operator=(const LightGL&&) = delete;
 
    [[nodiscard]] bool isLightOn() const;
    void toggleLightSwitch();
@@ -22,12 +30,43 @@ public:
    );
    void activateLight(const int& light_index);
    void deactivateLight(const int& light_index);
-   void transferUniformsToShader(const ShaderGL* shader);
+   // uploads the lights in the eye space of view_matrix, only when it or a light has changed since the last call.
+   void transferLightBuffer(const glm::mat4& view_matrix);
    [[nodiscard]] int getTotalLightNum() const { return TotalLightNum; }
    [[nodiscard]] glm::vec4 getLightPosition(int light_index) { return Positions[light_index]; }
 
 private:
+   // mirrors of the std140 layouts of LightInfo and LightBlock in screen.frag.
+   // the cutoff angle is in radians here, clamped to 90 degrees as the shader used to do per fragment.
+   struct LightInfo
+   {
+      glm::vec4 PositionInEC;
+      glm::vec4 AmbientColor;
+      glm::vec4 DiffuseColor;
+      glm::vec4 SpecularColor;
+      glm::vec3 SpotlightDirectionInEC;
+      float SpotlightCutoffAngle;
+      GLint LightSwitch;
+      float SpotlightFeather;
+      float FallOffRadius;
+      float SpotlightCosInnerCutoff;
+      float SpotlightCosCutoff;
+      float Padding[3];
+   };
+
+   struct LightBlock
+   {
+      GLint UseLight;
+      GLint LightNum;
+      GLint Padding[2];
+      glm::vec4 GlobalAmbient;
+      std::array<LightInfo, MaxLightNum> Lights;
+   };
+
    bool TurnLightOn;
+   bool LightBufferDirty;
+   GLuint LightBuffer;
+   glm::mat4 LightBufferViewMatrix;
    int TotalLightNum;
    glm::vec4 GlobalAmbientColor;
    std::vector<bool> IsActivated;
@@ -39,4 +78,10 @@ private:
    std::vector<float> SpotlightCutoffAngles;
    std::vector<float> SpotlightFeathers;
    std::vector<float> FallOffRadii;
+
+   [[nodiscard]] LightInfo getLightInfo(
+      int light_index,
+      const glm::mat4& view_matrix,
+      const glm::mat3& normal_matrix
+   ) const;
 };
\ No newline at end of file
@@ -1,12 +1,27 @@
 #pragma once
 
 #include "shader.h"
+#include "wave_solver_cpu.h"
 
 class ObjectGL
 {
 public:
    enum LayoutLocation { VertexLoc = 0, NormalLoc, TextureLoc };
 
+   // VertexAttributes fetches interleaved render vertices, and VertexPulling rebuilds them from gl_VertexID
+   // so that only the height and normal of each point are stored.
+   // HeightImage keeps the time levels in r32f textures which the vertex shader displaces a static grid with.
+   // TessellatedImage draws the same textures as patches of WavePatchSize points, subdivided by screen-space size.
+   // ClipmapImage draws them with nested rings of WaveClipmapSize cells around the camera instead of the whole grid.
+   enum class WaveRenderMode { VertexAttributes = 0, VertexPulling, HeightImage, TessellatedImage, ClipmapImage };
+
+   static constexpr int WavePatchSize = 32;
+   // separates the triangle strips of the grid rows, so that the whole surface is one draw call.
+   static constexpr GLuint WaveRestartIndex = 0xFFFFFFFFu;
+   static constexpr int WaveChunkSize = 32;
+   // the cells along each side of a clipmap level, a multiple of 4 so that the hole of a ring is a whole half.
+   static constexpr int WaveClipmapSize = 128;
+
    ObjectGL();
    ~ObjectGL();
 
@@ -48,11 +63,21 @@ public:
       const std::string& texture_file_path,
       bool is_grayscale = false
    );
-   void setWaveObject(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size);
+   void prepareWaveLevelCopies(int copy_num);
+   void copyWaveLevel(int index, int copy_index) const;
+   void prepareWaveReadback(int slot_num);
+   void requestWaveReadback(GLuint level);
+   [[nodiscard]] const GLfloat* getWaveReadback(int& request_age);
+   void setWaveObject(
+      const glm::ivec2& wave_point_num_size,
+      const glm::ivec2& wave_grid_size,
+      WaveRenderMode render_mode = WaveRenderMode::VertexAttributes
+   );
    int addTexture(const std::string& texture_file_path, bool is_grayscale = false);
    void addTexture(int width, int height, bool is_grayscale = false);
    int addTexture(const uint8_t* image_buffer, int width, int height, bool is_grayscale = false);
-   void transferUniformsToShader(const ShaderGL* shader);
+   // uploads the material only when a color or the exponent has changed since the last call.
+   void transferMaterialBuffer();
    void updateDataBuffer(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals);
    void updateDataBuffer(
       const std::vector<glm::vec3>& vertices,
@@ -62,6 +87,7 @@ public:
    void replaceVertices(const std::vector<glm::vec3>& vertices, bool normals_exist, bool textures_exist);
    void replaceVertices(const std::vector<float>& vertices, bool normals_exist, bool textures_exist);
    [[nodiscard]] GLuint getVAO() const { return VAO; }
+   [[nodiscard]] GLuint getVBO() const { return VBO; }
    [[nodiscard]] GLuint getIBO() const { return IBO; }
    [[nodiscard]] GLenum getDrawMode() const { return DrawMode; }
    [[nodiscard]] GLsizei getVertexNum() const { return VerticesCount; }
@@ -74,7 +100,23 @@ public:
       return it == CustomBuffers.end() ? 0 : it->second;
    }
    [[nodiscard]] GLuint getWaveBuffer(int index) { return WaveBuffers[index]; }
+   [[nodiscard]] GLuint getWaveImage(int index) const { return WaveImages[index]; }
+   void swapWaveSpareBuffer(int index) { std::swap( WaveBuffers[index], WaveSpareBuffer ); }
+   [[nodiscard]] GLuint getWaveSpareBuffer() const { return WaveSpareBuffer; }
+   [[nodiscard]] GLuint getWaveSurfaceBuffer() const { return WaveSurfaceBuffer; }
+   [[nodiscard]] GLuint getWaveChunkIndexBuffer() const { return WaveChunkIBO; }
+   [[nodiscard]] GLuint getWaveChunkBuffer() const { return WaveChunkBuffer; }
+   [[nodiscard]] GLuint getWaveChunkCommandBuffer() const { return WaveChunkCommandBuffer; }
+   [[nodiscard]] int getWaveChunkNum() const { return WaveChunkNum; }
+   [[nodiscard]] int getWaveClipmapLevelNum() const { return WaveClipmapLevelNum; }
+   [[nodiscard]] GLsizei getWaveClipmapIndexNum(int mesh) const
+   {
+      return static_cast<GLsizei>(WaveClipmapIndexOffsets[mesh + 1] - WaveClipmapIndexOffsets[mesh]);
+   }
+   [[nodiscard]] GLuint getWaveClipmapIndexOffset(int mesh) const { return WaveClipmapIndexOffsets[mesh]; }
+   [[nodiscard]] GLuint getWaveLevelCopy(int copy_index) const { return WaveLevelCopies[copy_index]; }
    [[nodiscard]] float getWaveFactor() const { return WaveFactor; }
+   [[nodiscard]] const glm::vec2& getWaveGridStep() const { return WaveGridStep; }
 
    template<typename T>
    void addCustomBufferObject(const std::string& name, int data_size)
@@ -86,16 +128,61 @@ public:
    }
 
 protected:
+   // matches the std140 layout of MaterialBlock in screen.frag.
+   struct MaterialBlock
+   {
+      glm::vec4 EmissionColor;
+      glm::vec4 AmbientColor;
+      glm::vec4 DiffuseColor;
+      glm::vec4 SpecularColor;
+      float SpecularExponent;
+      float Padding[3];
+   };
+
+   // matches the Chunk struct of wave_cull.comp.
+   struct WaveChunk
+   {
+      GLuint FirstIndex;
+      GLuint IndexCount;
+      glm::ivec2 PointMin;
+      glm::ivec2 PointMax;
+   };
+
+   // a persistently mapped copy of one time level. Fence signals the copy which RequestIndex issued.
+   struct WaveReadbackSlot
+   {
+      GLuint Buffer;
+      GLsync Fence;
+      const GLfloat* Heights;
+      int RequestIndex;
+   };
+
    GLuint VAO;
    GLuint VBO;
    GLuint IBO;
    GLenum DrawMode;
    GLsizei VerticesCount;
+   GLuint WaveSpareBuffer;
+   GLuint WaveSurfaceBuffer;
+   GLuint WaveChunkIBO;
+   GLuint WaveChunkBuffer;
+   GLuint WaveChunkCommandBuffer;
+   int WaveChunkNum;
+   int WaveClipmapLevelNum;
+   // the full grid of the finest level, then the rings whose hole is offset by one cell in x, y or both.
+   std::array<GLuint, 6> WaveClipmapIndexOffsets;
    std::array<GLuint, 3> WaveBuffers;
+   std::array<GLuint, 3> WaveImages;
+   // buffers or images like the time levels, which hold levels handed over from another context.
+   std::vector<GLuint> WaveLevelCopies;
+   int WaveReadbackRequestNum;
+   std::vector<WaveReadbackSlot> WaveReadbackSlots;
    std::vector<GLuint> TextureID;
    std::vector<GLfloat> DataBuffer;
    std::vector<GLuint> IndexBuffer;
    std::map<std::string, GLuint> CustomBuffers;
+   bool MaterialBufferDirty;
+   GLuint MaterialBuffer;
    glm::vec4 EmissionColor;
    glm::vec4 AmbientReflectionColor; // It is usually set to the same color with DiffuseReflectionColor.
                                      // Otherwise, it should be in balance with DiffuseReflectionColor.
@@ -103,12 +190,16 @@ protected:
    glm::vec4 SpecularReflectionColor;
    float SpecularReflectionExponent;
    float WaveFactor;
+   glm::vec2 WaveGridStep;
+   glm::ivec2 WavePointNumSize;
 
    [[nodiscard]] bool prepareTexture2DUsingFreeImage(const std::string& file_path, bool is_grayscale) const;
    void prepareNormal() const;
    void prepareTexture(bool normals_exist) const;
    void prepareVertexBuffer(int n_bytes_per_vertex);
    void prepareIndexBuffer();
+   void prepareWaveChunks(const glm::ivec2& wave_point_num_size);
+   void prepareWaveClipmap(const glm::ivec2& wave_point_num_size);
    static void getSquareObject(
       std::vector<glm::vec3>& vertices,
       std::vector<glm::vec3>& normals,
@@ -10,13 +10,17 @@
 #pragma once
 
 #include "base.h"
+#include "gpu_timer.h"
+#include "headless_context.h"
 #include "light.h"
 #include "object.h"
+#include "simulation_clock.h"
 
 class RendererGL
 {
 public:
-   RendererGL();
+   // a positive headless_frame_num draws that many frames without a window, saving every capture_interval-th one.
+   explicit RendererGL(int headless_frame_num = 0, int capture_interval = 0);
    ~RendererGL() = default;
 
    RendererGL(const RendererGL&) = delete;
@@ -24,37 +28,114 @@ public:
    RendererGL& operator=(const RendererGL&) = delete;
    RendererGL& operator=(const RendererGL&&) = delete;
 
+   // times the passes of every frame from the start and writes them to file_path as CSV.
+   void setGPUTimingLog(const std::string& file_path);
    void play();
+   // false when no OpenGL context could be created, in which case play() draws nothing.
+   [[nodiscard]] bool isInitialized() const { return Initialized; }
 
 private:
+   using WaveRenderMode = ObjectGL::WaveRenderMode;
+   using Uniform = ShaderGL::Uniform;
+
+   // Global reads every neighbour from the height buffer, and Tiled stages each group's block in shared memory first.
+   // Both are followed by a separate normal pass, which Fused folds into the step dispatch.
+   enum class WaveStepKernel { Global = 0, Tiled, Fused };
+
+   // the passes GPUTimer times, in the order of its pass names.
+   enum TimedPass { StepPass = 0, NormalPass, CullPass, DrawPass };
+
+   // a pair of consecutive levels which the simulation thread has copied for drawing. WrittenFence signals the copy,
+   // and ReadFence the end of the last frame which drew the pair, before which it must not be overwritten.
+   struct WavePublishSlot
+   {
+      GLsync WrittenFence;
+      GLsync ReadFence;
+      float LevelBlend;
+      std::chrono::steady_clock::time_point PublishTime;
+   };
+
    inline static RendererGL* Renderer = nullptr;
 
    GLFWwindow* Window;
+   GLFWwindow* SimulationWindow;
    int FrameWidth;
    int FrameHeight;
+   int HeadlessFrameNum;
+   int CaptureInterval;
+   bool Initialized;
    int ActiveLightIndex;
    int WaveTargetIndex;
+   int WaveDomainIndex;
+   WaveRenderMode RenderMode;
+   WaveStepKernel StepKernel;
+   bool SingleCallDraw;
+   bool ChunkCulling;
+   bool LevelInterpolation;
+   bool ThreadedSimulation;
+   bool HeightReadback;
+   int LatestPublishSlot;
+   int ReadingPublishSlot;
+   int DrawSubmitFrameNum;
+   double DrawSubmitTime;
+   int ReadbackFrameNum;
+   int ReadbackMissNum;
+   double ReadbackAgeSum;
+   float ReadbackCenterHeight;
+   float WaveLevelBlend;
+   std::chrono::steady_clock::time_point TimingTitleTime;
+   std::array<GLuint, 2> DrawnWaveLevels;
+   std::array<WavePublishSlot, 3> WavePublishSlots;
+   std::atomic<bool> SimulationStopped;
+   std::mutex PublishLock;
+   std::thread SimulationThread;
    glm::ivec2 WavePointNumSize;
    glm::ivec2 WaveGridSize;
    glm::ivec2 ClickedPoint;
+   // declared first so that it is destroyed last, after the objects whose names it has to delete.
+   std::unique_ptr<HeadlessContextGL> Headless;
+   std::unique_ptr<GPUTimerGL> GPUTimer;
    std::unique_ptr<CameraGL> MainCamera;
    std::unique_ptr<ShaderGL> ObjectShader;
    std::unique_ptr<ShaderGL> WaveShader;
+   std::unique_ptr<ShaderGL> WaveTiledShader;
+   std::unique_ptr<ShaderGL> WaveFusedShader;
+   std::unique_ptr<ShaderGL> WaveBlockedShader;
+   std::unique_ptr<ShaderGL> WaveImageShader;
+   std::unique_ptr<ShaderGL> WaveCullShader;
+   std::unique_ptr<ShaderGL> WaveImageCullShader;
    std::unique_ptr<ShaderGL> WaveNormalShader;
+   std::unique_ptr<ShaderGL> WavePullingShader;
+   std::unique_ptr<ShaderGL> WavePullingNormalShader;
+   std::unique_ptr<ShaderGL> WavePullingFusedShader;
+   std::unique_ptr<ShaderGL> WaveDisplacementShader;
+   std::unique_ptr<ShaderGL> WaveTessellationShader;
+   std::unique_ptr<ShaderGL> WaveClipmapShader;
    std::unique_ptr<ObjectGL> WaveObject;
    std::unique_ptr<LightGL> Lights;
+   std::unique_ptr<SimulationClock> WaveClock;
 
    // 16 and 32 do well, anything in between or below is bad.
    // 32 seems to do well on laptop/desktop Windows Intel and on NVidia/AMD as well.
    // further hardware-specific tuning might be needed for optimal performance.
    static constexpr int ThreadGroupSize = 32;
+   // wave_blocked.comp sizes its shared memory for this many substeps.
+   static constexpr int MaxWaveSubstepNum = 8;
+   // the wall-clock time one step of WaveSolverCPU::DeltaTime stands for, which is one step per frame at 60 Hz.
+   static constexpr double WaveStepInterval = 1.0 / 60.0;
+   // the CPU reads heights at most this many frames old, as long as the GPU is no further behind.
+   static constexpr int WaveReadbackSlotNum = 3;
+   // the tessellated wave splits its patch edges into pieces of about this many pixels.
+   static constexpr float TessellationEdgeLength = 8.0f;
+   // the points along each side of the selectable wave domains. only the clipmap draws the larger ones interactively.
+   static constexpr std::array<int, 4> WaveDomainSizes{ 100, 1024, 4096, 16384 };
    [[nodiscard]] static int getGroupSize(int size)
    {
       return (size + ThreadGroupSize - 1) / ThreadGroupSize;
    }
 
    void registerCallbacks() const;
-   void initialize();
+   [[nodiscard]] bool initialize();
 
    static void printOpenGLInformation();
 
@@ -65,6 +146,24 @@ private:
    static void mousewheel(GLFWwindow* window, double xoffset, double yoffset);
 
    void setLights();
+   void setWaveDomainSize(int domain_index);
+   void setWaveObject();
+   void updateWaveImages(int step_num);
+   [[nodiscard]] bool stepWave(int step_num, WaveStepKernel step_kernel);
+   void estimateWaveSurface();
+   void updateWave();
+   void simulateWave();
+   void publishWaveLevels();
+   [[nodiscard]] bool acquireWaveLevels();
+   void releaseWaveLevels();
+   void startWaveThread();
+   void stopWaveThread();
+   void readBackWaveHeights();
+   void cullWaveChunks();
+   void drawWaveClipmap(const ShaderGL* shader) const;
    void drawWaveObject();
+   void showGPUTimes();
    void render();
+   [[nodiscard]] bool captureFrame(const std::string& file_path) const;
+   void playHeadless();
 };
\ No newline at end of file
@@ -2,32 +2,17 @@
 
 #include "base.h"
 #include "camera.h"
+#include "cpu_profiler.h"
 
 class ShaderGL final
 {
 public:
-   struct LightLocationSet
+   // the uniforms which the wave and scene shaders set every frame. the set*UniformLocations functions look each one
+   // up once, so that setting it indexes an array instead of building and hashing a string.
+   enum class Uniform
    {
-      GLint LightSwitch, LightPosition;
-      GLint LightAmbient, LightDiffuse, LightSpecular, LightFallOffRadius;
-      GLint SpotlightDirection, SpotlightCutoffAngle, SpotlightFeather;
-
-      LightLocationSet() : LightSwitch( 0 ), LightPosition( 0 ), LightAmbient( 0 ), LightDiffuse( 0 ),
-      LightSpecular( 0 ), LightFallOffRadius( 0 ), SpotlightDirection( 0 ), SpotlightCutoffAngle( 0 ),
-      SpotlightFeather( 0 ) {}
-   };
-
-   struct LocationSet
-   {
-      GLint World, View, Projection, ModelViewProjection;
-      GLint MaterialEmission, MaterialAmbient, MaterialDiffuse, MaterialSpecular, MaterialSpecularExponent;
-      std::map<GLint, GLint> Texture; // <binding point, texture id>
-      GLint UseLight, LightNum, GlobalAmbient;
-      std::vector<LightLocationSet> Lights;
-
-      LocationSet() : World( 0 ), View( 0 ), Projection( 0 ), ModelViewProjection( 0 ), MaterialEmission( 0 ),
-      MaterialAmbient( 0 ), MaterialDiffuse( 0 ), MaterialSpecular( 0 ), MaterialSpecularExponent( 0 ), UseLight( 0 ),
-      LightNum( 0 ), GlobalAmbient( 0 ) {}
+      WaveFactor = 0, WavePointNumSize, WaveGridStep, WaveLevelBlend, SubstepNum, ModelViewProjectionMatrix, UseTexture,
+      LightIndex, PatchSize, ViewportSize, TargetEdgeLength, ClipmapSize, ClipmapLevel, ClipmapOrigin, Count
    };
 
    ShaderGL();
@@ -40,106 +25,99 @@ public:
       const char* tessellation_control_shader_path = nullptr,
       const char* tessellation_evaluation_shader_path = nullptr
    );
-   void setComputeShaders(const char* compute_shader_path);
+   void setComputeShaders(const char* compute_shader_path, const std::vector<std::string>& defines = {});
+   // linked programs are kept there as driver binaries, and found again by a hash of their sources and the driver.
+   // nothing is cached while the directory is empty.
+   static void setProgramCacheDirectory(const std::string& directory_path);
    void setWaveUniformLocations();
    void setWaveNormalUniformLocations();
-   void setSceneUniformLocations(int light_num);
+   void setWaveFusedUniformLocations();
+   void setWaveBlockedUniformLocations();
+   void setWaveCullUniformLocations();
+   void setSceneUniformLocations();
+   void setWaveSceneUniformLocations();
+   void setWaveTessellationUniformLocations();
+   void setWaveClipmapUniformLocations();
+   void addUniformLocation(Uniform uniform)
+   {
+      const auto index = static_cast<size_t>(uniform);
+      UniformLocations[index] = glGetUniformLocation( ShaderProgram, UniformNames[index] );
+   }
+   // any other uniform, which is looked up by name and so better kept out of the per-frame path.
    void addUniformLocation(const std::string& name)
    {
       CustomLocations[name] = glGetUniformLocation( ShaderProgram, name.c_str() );
    }
-   void transferBasicTransformationUniforms(const glm::mat4& to_world, const CameraGL* camera) const;
-   void uniform1i(const char* name, int value) const
+   void uniform1i(Uniform uniform, int value) const
    {
-      glProgramUniform1i( ShaderProgram, CustomLocations.find( name )->second, value );
+      glProgramUniform1i( ShaderProgram, getLocation( uniform ), value );
    }
-   void uniform1f(const char* name, float value) const
+   void uniform1f(Uniform uniform, float value) const
    {
-      glProgramUniform1f( ShaderProgram, CustomLocations.find( name )->second, value );
+      glProgramUniform1f( ShaderProgram, getLocation( uniform ), value );
    }
-   void uniform1fv(const char* name, int count, const float* value) const
+   void uniform1fv(Uniform uniform, int count, const float* value) const
    {
-      glProgramUniform1fv( ShaderProgram, CustomLocations.find( name )->second, count, value );
+      glProgramUniform1fv( ShaderProgram, getLocation( uniform ), count, value );
    }
-   void uniform2fv(const char* name, const glm::vec2& value) const
+   void uniform2fv(Uniform uniform, const glm::vec2& value) const
    {
-      glProgramUniform2fv( ShaderProgram, CustomLocations.find( name )->second, 1, &value[0] );
+      glProgramUniform2fv( ShaderProgram, getLocation( uniform ), 1, &value[0] );
    }
-   void uniform2fv(const char* name, int count, const float* value) const
+   void uniform2fv(Uniform uniform, int count, const float* value) const
    {
-      glProgramUniform2fv( ShaderProgram, CustomLocations.find( name )->second, count, value );
+      glProgramUniform2fv( ShaderProgram, getLocation( uniform ), count, value );
    }
-   void uniform3fv(const char* name, const glm::vec3& value) const
+   void uniform3fv(Uniform uniform, const glm::vec3& value) const
    {
-      glProgramUniform3fv( ShaderProgram, CustomLocations.find( name )->second, 1, &value[0] );
+      glProgramUniform3fv( ShaderProgram, getLocation( uniform ), 1, &value[0] );
    }
-   void uniform4fv(const char* name, const glm::vec4& value) const
+   void uniform4fv(Uniform uniform, const glm::vec4& value) const
    {
-      glProgramUniform4fv( ShaderProgram, CustomLocations.find( name )->second, 1, &value[0] );
+      glProgramUniform4fv( ShaderProgram, getLocation( uniform ), 1, &value[0] );
    }
-   void uniformMat3fv(const char* name, const glm::mat3& value) const
+   void uniformMat3fv(Uniform uniform, const glm::mat3& value) const
    {
-      glProgramUniformMatrix3fv( ShaderProgram, CustomLocations.find( name )->second, 1, GL_FALSE, &value[0][0] );
+      glProgramUniformMatrix3fv( ShaderProgram, getLocation( uniform ), 1, GL_FALSE, &value[0][0] );
    }
-   void uniformMat4fv(const char* name, const glm::mat4& value) const
+   void uniformMat4fv(Uniform uniform, const glm::mat4& value) const
    {
-      glProgramUniformMatrix4fv( ShaderProgram, CustomLocations.find( name )->second, 1, GL_FALSE, &value[0][0] );
+      glProgramUniformMatrix4fv( ShaderProgram, getLocation( uniform ), 1, GL_FALSE, &value[0][0] );
    }
    [[nodiscard]] GLuint getShaderProgram() const { return ShaderProgram; }
+   [[nodiscard]] GLint getLocation(Uniform uniform) const { return UniformLocations[static_cast<size_t>(uniform)]; }
    [[nodiscard]] GLint getLocation(const std::string& name) const { return CustomLocations.find( name )->second; }
-   [[nodiscard]] GLint getMaterialEmissionLocation() const { return Location.MaterialEmission; }
-   [[nodiscard]] GLint getMaterialAmbientLocation() const { return Location.MaterialAmbient; }
-   [[nodiscard]] GLint getMaterialDiffuseLocation() const { return Location.MaterialDiffuse; }
-   [[nodiscard]] GLint getMaterialSpecularLocation() const { return Location.MaterialSpecular; }
-   [[nodiscard]] GLint getMaterialSpecularExponentLocation() const { return Location.MaterialSpecularExponent; }
-   [[nodiscard]] GLint getLightAvailabilityLocation() const { return Location.UseLight; }
-   [[nodiscard]] GLint getLightNumLocation() const { return Location.LightNum; }
-   [[nodiscard]] GLint getGlobalAmbientLocation() const { return Location.GlobalAmbient; }
-   [[nodiscard]] GLint getLightSwitchLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightSwitch;
-   }
-   [[nodiscard]] GLint getLightPositionLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightPosition;
-   }
-   [[nodiscard]] GLint getLightAmbientLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightAmbient;
-   }
-   [[nodiscard]] GLint getLightDiffuseLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightDiffuse;
-   }
-   [[nodiscard]] GLint getLightSpecularLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightSpecular;
-   }
-   [[nodiscard]] GLint getLightSpotlightDirectionLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightDirection;
-   }
-   [[nodiscard]] GLint getLightSpotlightCutoffAngleLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightCutoffAngle;
-   }
-   [[nodiscard]] GLint getLightSpotlightFeatherLocation(int light_index) const
-   {
-      return Location.Lights[light_index].SpotlightFeather;
-   }
-   [[nodiscard]] GLint getLightFallOffRadiusLocation(int light_index) const
-   {
-      return Location.Lights[light_index].LightFallOffRadius;
-   }
 
 protected:
+   // the type and the contents of each shader of a program, with the defines already inserted.
+   using ShaderSources = std::vector<std::pair<GLenum, std::string>>;
+
+   static constexpr std::array<const char*, static_cast<size_t>(Uniform::Count)> UniformNames{
+      "WaveFactor", "WavePointNumSize", "WaveGridStep", "WaveLevelBlend", "SubstepNum", "ModelViewProjectionMatrix",
+      "UseTexture", "LightIndex", "PatchSize", "ViewportSize", "TargetEdgeLength", "ClipmapSize", "ClipmapLevel",
+      "ClipmapOrigin"
+   };
+
+   inline static std::string ProgramCacheDirectory;
+
    GLuint ShaderProgram;
-   LocationSet Location;
+   // -1 for the uniforms the program was not asked to look up, which glUniform* then ignores.
+   std::array<GLint, static_cast<size_t>(Uniform::Count)> UniformLocations;
    std::unordered_map<std::string, GLint> CustomLocations;
 
    static void readShaderFile(std::string& shader_contents, const char* shader_path);
+   static void insertDefines(std::string& shader_contents, const std::vector<std::string>& defines);
+   static void addShaderSource(
+      ShaderSources& sources,
+      GLenum shader_type,
+      const char* shader_path,
+      const std::vector<std::string>& defines = {}
+   );
    [[nodiscard]] static std::string getShaderTypeString(GLenum shader_type);
    [[nodiscard]] static bool checkCompileError(GLenum shader_type, const GLuint& shader);
-   [[nodiscard]] static GLuint getCompiledShader(GLenum shader_type, const char* shader_path);
-   void setBasicTransformationUniforms();
+   [[nodiscard]] static GLuint getCompiledShader(GLenum shader_type, const std::string& shader_contents);
+   [[nodiscard]] static std::string getProgramCachePath(const ShaderSources& sources);
+   [[nodiscard]] bool loadProgramBinary(const std::string& cache_path);
+   void saveProgramBinary(const std::string& cache_path) const;
+   void linkProgram(const ShaderSources& sources);
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+
+// Turns wall-clock time into a whole number of fixed simulation steps, so the simulation runs at the same speed
+// whatever the frame rate is. The time left over is kept for the next frame, and its fraction of a step tells
+// how far the rendered surface is between the last two time levels.
+// At most MaxStepNum steps are taken per frame, and the time beyond them is dropped,
+// so a frame which is slow to simulate does not make the next frames slower still.
+class SimulationClock final
+{
+public:
+   SimulationClock(double step_interval, int max_step_num);
+   ~SimulationClock() = default;
+
+   SimulationClock(const SimulationClock&) = delete;
+   SimulationClock(const SimulationClock&&) = delete;
+   SimulationClock& operator=(const SimulationClock&) = delete;
+   SimulationClock& operator=(const SimulationClock&&) = delete;
+
+   void reset();
+   [[nodiscard]] int advance();
+   [[nodiscard]] int advance(double elapsed_time);
+   void setMaxStepNum(int max_step_num) { MaxStepNum = max_step_num; }
+   [[nodiscard]] int getMaxStepNum() const { return MaxStepNum; }
+   [[nodiscard]] double getStepInterval() const { return StepInterval; }
+   [[nodiscard]] double getDroppedTime() const { return DroppedTime; }
+   [[nodiscard]] float getLevelBlend() const { return static_cast<float>(Accumulator / StepInterval); }
+
+private:
+   double StepInterval;
+   int MaxStepNum;
+   double Accumulator;
+   double DroppedTime;
+   std::chrono::steady_clock::time_point LastTime;
+};
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent workers for the CPU solver. run() hands the same task to every thread and returns once all of them
+// have finished it, so each call acts as a barrier without spawning threads per step.
+// The calling thread takes part as thread 0. With pinned threads, the thread which constructs the pool is pinned
+// to core 0 until the pool is destroyed, so it has to be the one which calls run().
+class ThreadPool final
+{
+public:
+   explicit ThreadPool(int thread_num = 0, bool pin_threads = false);
+   ~ThreadPool();
+
+   ThreadPool(const ThreadPool&) = delete;
+   ThreadPool(const ThreadPool&&) = delete;
+   ThreadPool& operator=(const ThreadPool&) = delete;
+   ThreadPool& operator=(const ThreadPool&&) = delete;
+
+   void run(const std::function<void(int)>& task);
+   [[nodiscard]] int getThreadNum() const { return ThreadNum; }
+   [[nodiscard]] bool areThreadsPinned() const { return PinThreads; }
+   [[nodiscard]] static int getHardwareThreadNum();
+
+private:
+   int ThreadNum;
+   bool PinThreads;
+   bool Terminate;
+   uint64_t Generation;
+   std::atomic<uint64_t> PublishedGeneration;
+   std::atomic<int> RemainingWorkers;
+   const std::function<void(int)>* Task;
+   std::mutex Lock;
+   std::condition_variable TaskReady;
+   std::condition_variable TaskDone;
+   std::vector<std::thread> Workers;
+   // the affinity of the constructing thread before it was pinned, as the platform's cpu set or mask.
+   std::array<uint64_t, 16> CallerAffinity;
+
+   // workers spin this many times on a new generation before they go to sleep,
+   // which keeps the hand-off cheap when steps follow each other closely.
+   static constexpr int SpinCount = 4096;
+
+   void work(int thread_index);
+   static void pinCurrentThread(int core_index);
+   void saveCallerAffinity();
+   void restoreCallerAffinity() const;
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+
+// Row kernels of the wave update used by WaveSolverCPU. A kernel updates `count` consecutive cells which all have
+// their left and right neighbours in memory; curr_up and curr_down are nullptr on the first and last rows.
+// Every kernel performs the operations of wave.comp in the same order, so all of them produce identical results.
+using WaveRowKernel = void (*)(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+);
+
+enum class WaveKernelISA { Scalar = 0, SSE42, AVX2, AVX512 };
+
+[[nodiscard]] WaveKernelISA getBestSupportedWaveKernelISA();
+[[nodiscard]] bool isWaveKernelISASupported(WaveKernelISA isa);
+[[nodiscard]] WaveRowKernel getWaveRowKernel(WaveKernelISA isa);
+[[nodiscard]] std::string getWaveKernelISAString(WaveKernelISA isa);
+
+void updateWaveRowScalar(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+);
+
+#ifdef WAVE_KERNEL_X86
+void updateWaveRowSSE42(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+);
+void updateWaveRowAVX2(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+);
+void updateWaveRowAVX512(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+);
+#endif
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "wave_kernel_cpu.h"
+#include "thread_pool.h"
+
+#include <glm.hpp>
+#include <gtc/constants.hpp>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cmath>
+#include <iostream>
+#include <memory>
+
+// CPU reference of wave.comp and wave_normal.comp. It has no OpenGL dependency, so it can step the simulation
+// on machines without a GPU and serve as the ground truth for the compute shader path.
+class WaveSolverCPU final
+{
+public:
+   static constexpr float WaveSpeed = 10.0f;
+   static constexpr float DeltaTime = 0.0009f;
+
+   WaveSolverCPU();
+   ~WaveSolverCPU() = default;
+
+   WaveSolverCPU(const WaveSolverCPU&) = delete;
+   WaveSolverCPU(const WaveSolverCPU&&) = delete;
+   WaveSolverCPU& operator=(const WaveSolverCPU&) = delete;
+   WaveSolverCPU& operator=(const WaveSolverCPU&&) = delete;
+
+   void initialize(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size);
+   void setKernelISA(WaveKernelISA isa);
+   void setThreadNum(int thread_num, bool pin_threads = false);
+   void setTemporalBlocking(int block_step_num, int tile_size = 0);
+   void step();
+   void step(int step_num);
+   void advance(int step_num);
+   void updateWave();
+   void estimateNormals();
+   [[nodiscard]] WaveKernelISA getKernelISA() const { return KernelISA; }
+   [[nodiscard]] int getThreadNum() const { return Pool == nullptr ? 1 : Pool->getThreadNum(); }
+   [[nodiscard]] int getBlockStepNum() const { return BlockStepNum; }
+   [[nodiscard]] int getTargetIndex() const { return TargetIndex; }
+   [[nodiscard]] float getWaveFactor() const { return WaveFactor; }
+   [[nodiscard]] const glm::ivec2& getWavePointNumSize() const { return WavePointNumSize; }
+   [[nodiscard]] const glm::vec2& getWaveGridStep() const { return WaveGridStep; }
+   [[nodiscard]] const std::vector<float>& getHeights(int index) const { return Heights[index]; }
+   [[nodiscard]] const std::vector<float>& getCurrentHeights() const { return Heights[(TargetIndex + 1) % 3]; }
+   [[nodiscard]] const std::vector<glm::vec3>& getNormals() const { return Normals; }
+   [[nodiscard]] glm::vec3 getPoint(int x, int y) const
+   {
+      return {
+         static_cast<float>(x) * WaveGridStep.x,
+         getCurrentHeights()[y * WavePointNumSize.x + x],
+         static_cast<float>(y) * WaveGridStep.y
+      };
+   }
+
+   [[nodiscard]] static glm::vec2 getWaveGridStep(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size);
+   [[nodiscard]] static float getWaveFactor(float grid_step, float delta_time = DeltaTime);
+   [[nodiscard]] static float getInitialHeight(const glm::ivec2& wave_point_num_size, int x, int y);
+
+private:
+   WaveKernelISA KernelISA;
+   WaveRowKernel RowKernel;
+   int TargetIndex;
+   int BlockStepNum;
+   int TileSize;
+   float WaveFactor;
+   glm::ivec2 WavePointNumSize;
+   glm::vec2 WaveGridStep;
+
+   // The three time levels rotate exactly like the wave buffers of the compute shader path:
+   // Heights[TargetIndex] is Pn_prev, the next one is Pn, and the last one receives Pn_next.
+   std::array<std::vector<float>, 3> Heights;
+   std::vector<glm::vec3> Normals;
+   std::unique_ptr<ThreadPool> Pool;
+
+   // Temporal blocking advances one tile by BlockStepNum steps in a per-thread scratch before it moves on.
+   // The last two time levels go to the spare grids because the neighbouring tiles still read the old ones.
+   std::array<std::vector<float>, 2> SpareHeights;
+   std::vector<std::array<std::vector<float>, 3>> TileScratches;
+
+   // the three scratch levels of a tile should stay in L2 while the tile is advanced
+   static constexpr size_t TileCacheBytes = 512 * 1024;
+
+   void runInRowBands(const std::function<void(int, int)>& task) const;
+   void updateWaveRows(int begin, int end);
+   void estimateNormalRows(int begin, int end);
+   void updateWaveRow(
+      float* next,
+      const float* prev,
+      const float* curr,
+      const float* curr_up,
+      const float* curr_down,
+      int begin,
+      int end
+   ) const;
+   [[nodiscard]] int getTileSize(int block_step_num) const;
+   void advanceTile(int block_step_num, const glm::ivec2& tile_min, const glm::ivec2& tile_max, int thread_index);
+   void advanceTemporalBlock(int block_step_num);
+   void advanceHeights(int step_num);
+};
\ No newline at end of file
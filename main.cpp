@@ -1,8 +1,45 @@
 #include "renderer.h"
 
-int main()
+int main(int argc, char* argv[])
 {
-   RendererGL renderer;
+   // --headless <frame number> draws without a window, and --capture <interval> saves every interval-th frame then.
+   // --timing-csv <file> writes the GPU time of each pass of every frame to the file.
+   // --cpu-trace <file> profiles the CPU from the start and saves the zones of the frames --trace-frames <a:b> selects.
+   int headless_frame_num = 0;
+   int capture_interval = 0;
+   int64_t first_trace_frame = 0;
+   int64_t last_trace_frame = std::numeric_limits<int64_t>::max();
+   std::string timing_file_path;
+   std::string trace_file_path;
+   for (int i = 1; i + 1 < argc; i += 2) {
+      const std::string option = argv[i];
+      if (option == "--headless") headless_frame_num = std::stoi( argv[i + 1] );
+      else if (option == "--capture") capture_interval = std::stoi( argv[i + 1] );
+      else if (option == "--timing-csv") timing_file_path = argv[i + 1];
+      else if (option == "--cpu-trace") trace_file_path = argv[i + 1];
+      else if (option == "--trace-frames") {
+         const std::string frames = argv[i + 1];
+         const size_t colon = frames.find( ':' );
+         first_trace_frame = std::stoll( frames.substr( 0, colon ) );
+         if (colon != std::string::npos) last_trace_frame = std::stoll( frames.substr( colon + 1 ) );
+      }
+   }
+   if (!trace_file_path.empty()) {
+      CPUProfiler::setThreadName( "render" );
+      CPUProfiler::setEnabled( true );
+   }
+
+   // the programs are cached next to the executable, so that a launch after the first one links no shader sources.
+   ShaderGL::setProgramCacheDirectory( (std::filesystem::path(argv[0]).parent_path() / "shader_cache").string() );
+
+   // a render farm or a CI machine without EGL should see the run fail, not a frame count of zero.
+   RendererGL renderer( headless_frame_num, capture_interval );
+   if (!renderer.isInitialized()) return 1;
+   if (!timing_file_path.empty()) renderer.setGPUTimingLog( timing_file_path );
    renderer.play();
+   if (!trace_file_path.empty() &&
+       !CPUProfiler::exportChromeTrace( trace_file_path, first_trace_frame, last_trace_frame )) {
+      std::cout << "Cannot Save " << trace_file_path << "\n";
+   }
    return 0;
 }
\ No newline at end of file
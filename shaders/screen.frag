@@ -1,40 +1,45 @@
-#version 460
+#version 450
 
 #define MAX_LIGHTS 32
 
+// the std140 blocks which LightGL and ObjectGL upload only when a light, the view or the material changes.
+// the members are ordered so that no vec3 straddles 16 bytes, as LightGL::LightInfo mirrors them.
+// the lights are already in eye space, and the cones of the spotlights are given by the cosines of their angles.
 struct LightInfo
 {
-   int LightSwitch;
-   vec4 Position;
+   vec4 PositionInEC;
    vec4 AmbientColor;
    vec4 DiffuseColor;
    vec4 SpecularColor;
-   vec3 SpotlightDirection;
+   vec3 SpotlightDirectionInEC;
    float SpotlightCutoffAngle;
+   int LightSwitch;
    float SpotlightFeather;
    float FallOffRadius;
+   float SpotlightCosInnerCutoff;
+   float SpotlightCosCutoff;
+};
+
+layout (std140, binding = 2) uniform LightBlock
+{
+   int UseLight;
+   int LightNum;
+   vec4 GlobalAmbient;
+   LightInfo Lights[MAX_LIGHTS];
 };
-uniform LightInfo Lights[MAX_LIGHTS];
 
-struct MateralInfo {
+layout (std140, binding = 1) uniform MaterialBlock
+{
    vec4 EmissionColor;
    vec4 AmbientColor;
    vec4 DiffuseColor;
    vec4 SpecularColor;
    float SpecularExponent;
-};
-uniform MateralInfo Material;
+} Material;
 
 layout (binding = 0) uniform sampler2D BaseTexture;
 uniform int UseTexture;
 
-uniform int UseLight;
-uniform int LightNum;
-uniform vec4 GlobalAmbient;
-
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-
 in vec3 position_in_ec;
 in vec3 normal_in_ec;
 in vec2 tex_coord;
@@ -62,19 +67,14 @@ float getAttenuation(in vec3 light_vector, in int light_index)
 
 float getSpotlightFactor(in vec3 normalized_light_vector, in int light_index)
 {
-   if (Lights[light_index].SpotlightCutoffAngle >= 180.0f) return one;
-
-   vec4 direction_in_ec = transpose( inverse( ViewMatrix ) ) * vec4(Lights[light_index].SpotlightDirection, zero);
-   vec3 normalized_direction = normalize( direction_in_ec.xyz );
-   float factor = dot( -normalized_light_vector, normalized_direction );
-   float cutoff_angle = radians( clamp( Lights[light_index].SpotlightCutoffAngle, zero, 90.0f ) );
-   if (factor >= cos( cutoff_angle )) {
-      float normalized_angle = acos( factor ) * half_pi / cutoff_angle;
-      float threshold = half_pi * (one - Lights[light_index].SpotlightFeather);
-      return normalized_angle <= threshold ? one :
-         cos( half_pi * (normalized_angle - threshold) / (half_pi - threshold) );
-   }
-   return zero;
+   // inside the inner cone, which is all of it without feather, the factor is one and no angle is needed.
+   float factor = dot( -normalized_light_vector, Lights[light_index].SpotlightDirectionInEC );
+   if (factor >= Lights[light_index].SpotlightCosInnerCutoff) return one;
+   if (factor < Lights[light_index].SpotlightCosCutoff) return zero;
+
+   float normalized_angle = acos( factor ) * half_pi / Lights[light_index].SpotlightCutoffAngle;
+   float threshold = half_pi * (one - Lights[light_index].SpotlightFeather);
+   return cos( half_pi * (normalized_angle - threshold) / (half_pi - threshold) );
 }
 
 vec4 calculateLightingEquation()
@@ -84,7 +84,7 @@ vec4 calculateLightingEquation()
    for (int i = 0; i < LightNum; ++i) {
       if (Lights[i].LightSwitch == 0) continue;
       
-      vec4 light_position_in_ec = ViewMatrix * Lights[i].Position;
+      vec4 light_position_in_ec = Lights[i].PositionInEC;
       
       float final_effect_factor = one;
       vec3 light_vector = light_position_in_ec.xyz - position_in_ec;
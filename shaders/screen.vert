@@ -1,9 +1,15 @@
-#version 460
+#version 450
 
-uniform mat4 WorldMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 ProjectionMatrix;
-uniform mat4 ModelViewProjectionMatrix;
+// CameraGL updates the block only when the camera moves, and every program reads it from the same binding.
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   // the inverse transpose of the model-view matrix, for the normals.
+   mat3 NormalMatrix;
+};
 
 layout (location = 0) in vec3 v_position;
 layout (location = 1) in vec3 v_normal;
@@ -16,9 +22,8 @@ out vec2 tex_coord;
 void main()
 {   
    vec4 e_position = ViewMatrix * WorldMatrix * vec4(v_position, 1.0f);
-   vec4 e_normal = transpose( inverse( ViewMatrix * WorldMatrix ) ) * vec4(v_normal, 1.0f);
    position_in_ec = e_position.xyz;
-   normal_in_ec = normalize( e_normal.xyz );
+   normal_in_ec = normalize( NormalMatrix * v_normal );
 
    tex_coord = v_tex_coord;  
 
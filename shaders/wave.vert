@@ -0,0 +1,36 @@
+#version 450
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   mat3 NormalMatrix;
+};
+uniform ivec2 WavePointNumSize;
+uniform vec2 WaveGridStep;
+
+// height and normal of every grid point, written by wave_normal.comp.
+// x, z, s and t are functions of the grid index, so they are rebuilt from gl_VertexID instead of being fetched.
+layout (binding = 0, std430) readonly buffer Surface { vec4 HeightNormals[]; };
+
+out vec3 position_in_ec;
+out vec3 normal_in_ec;
+out vec2 tex_coord;
+
+void main()
+{   
+   ivec2 point = ivec2(gl_VertexID % WavePointNumSize.x, gl_VertexID / WavePointNumSize.x);
+   vec4 height_normal = HeightNormals[gl_VertexID];
+   vec3 v_position = vec3(float(point.x) * WaveGridStep.x, height_normal.x, float(point.y) * WaveGridStep.y);
+   vec3 v_normal = height_normal.yzw;
+
+   vec4 e_position = ViewMatrix * WorldMatrix * vec4(v_position, 1.0f);
+   position_in_ec = e_position.xyz;
+   normal_in_ec = normalize( NormalMatrix * v_normal );
+
+   tex_coord = vec2(point) / vec2(WavePointNumSize - 1);
+
+   gl_Position = ModelViewProjectionMatrix * vec4(v_position, 1.0f);
+}
\ No newline at end of file
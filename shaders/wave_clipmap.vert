@@ -0,0 +1,66 @@
+#version 450
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   mat3 NormalMatrix;
+};
+uniform ivec2 WavePointNumSize;
+uniform vec2 WaveGridStep;
+uniform int ClipmapSize;
+uniform int ClipmapLevel;
+uniform ivec2 ClipmapOrigin;
+
+// the newest level written by wave_image.comp. a level of the clipmap spaces its vertices 2^ClipmapLevel points
+// apart from ClipmapOrigin, which is a multiple of twice that spacing so the vertices of the next level lie on it.
+layout (binding = 1) uniform sampler2D WaveHeights;
+layout (binding = 2) uniform sampler2D PrevWaveHeights;
+uniform float WaveLevelBlend;
+
+out vec3 position_in_ec;
+out vec3 normal_in_ec;
+out vec2 tex_coord;
+
+float getHeight(in ivec2 point)
+{
+   const ivec2 texel = clamp( point, ivec2(0), WavePointNumSize - 1 );
+   return mix( texelFetch( PrevWaveHeights, texel, 0 ).r, texelFetch( WaveHeights, texel, 0 ).r, WaveLevelBlend );
+}
+
+void main()
+{
+   const ivec2 local_point = ivec2(gl_VertexID % (ClipmapSize + 1), gl_VertexID / (ClipmapSize + 1));
+   const int step = 1 << ClipmapLevel;
+   const ivec2 point = clamp( ClipmapOrigin + local_point * step, ivec2(0), WavePointNumSize - 1 );
+   float height = getHeight( point );
+
+   // the coarser level around this one only has every other vertex of the outer edge,
+   // so the vertices in between lie on its edges instead of leaving cracks.
+   const bool x_edge = local_point.x == 0 || local_point.x == ClipmapSize;
+   const bool y_edge = local_point.y == 0 || local_point.y == ClipmapSize;
+   if (x_edge && (local_point.y & 1) == 1) {
+      height = 0.5f * (getHeight( point - ivec2(0, step) ) + getHeight( point + ivec2(0, step) ));
+   }
+   else if (y_edge && (local_point.x & 1) == 1) {
+      height = 0.5f * (getHeight( point - ivec2(step, 0) ) + getHeight( point + ivec2(step, 0) ));
+   }
+   const vec3 v_position = vec3(float(point.x) * WaveGridStep.x, height, float(point.y) * WaveGridStep.y);
+
+   // central differences over one vertex spacing on each side.
+   const float dx = getHeight( point + ivec2(step, 0) ) - getHeight( point - ivec2(step, 0) );
+   const float dy = getHeight( point + ivec2(0, step) ) - getHeight( point - ivec2(0, step) );
+   const vec3 v_normal = normalize(
+      vec3(-dx * WaveGridStep.y, 2.0f * float(step) * WaveGridStep.x * WaveGridStep.y, -dy * WaveGridStep.x)
+   );
+
+   vec4 e_position = ViewMatrix * WorldMatrix * vec4(v_position, 1.0f);
+   position_in_ec = e_position.xyz;
+   normal_in_ec = normalize( NormalMatrix * v_normal );
+
+   tex_coord = vec2(point) / vec2(WavePointNumSize - 1);
+
+   gl_Position = ModelViewProjectionMatrix * vec4(v_position, 1.0f);
+}
\ No newline at end of file
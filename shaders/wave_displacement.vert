@@ -0,0 +1,83 @@
+#version 450
+
+layout (std140, binding = 0) uniform CameraBlock
+{
+   mat4 WorldMatrix;
+   mat4 ViewMatrix;
+   mat4 ProjectionMatrix;
+   mat4 ModelViewProjectionMatrix;
+   mat3 NormalMatrix;
+};
+uniform ivec2 WavePointNumSize;
+uniform vec2 WaveGridStep;
+
+// the newest level written by wave_image.comp. the static grid is rebuilt from gl_VertexID
+// and displaced by it, and the normal is estimated from the neighbouring texels as in wave_normal.comp.
+layout (binding = 1) uniform sampler2D WaveHeights;
+// the level before it, which the surface is drawn between as wave_normal.comp does.
+layout (binding = 2) uniform sampler2D PrevWaveHeights;
+uniform float WaveLevelBlend;
+
+out vec3 position_in_ec;
+out vec3 normal_in_ec;
+out vec2 tex_coord;
+
+vec3 getPoint(in int x, in int y)
+{
+   const float height = mix(
+      texelFetch( PrevWaveHeights, ivec2(x, y), 0 ).r, texelFetch( WaveHeights, ivec2(x, y), 0 ).r, WaveLevelBlend
+   );
+   return vec3(float(x) * WaveGridStep.x, height, float(y) * WaveGridStep.y);
+}
+
+vec3 getNormal(in int x, in int y, in vec3 point_vec)
+{
+   vec3 estimated_normal = vec3(0.0f);
+   if (y > 0) {
+      vec3 top_vec = getPoint( x, y - 1 ) - point_vec;
+      if (x > 0) {
+         vec3 left_vec = getPoint( x - 1, y ) - point_vec;
+         vec3 top_left_vec = getPoint( x - 1, y - 1 ) - point_vec;
+         estimated_normal += cross( top_vec, top_left_vec );
+         estimated_normal += cross( top_left_vec, left_vec );
+      }
+      if (x < WavePointNumSize.x - 1) {
+         vec3 right_vec = getPoint( x + 1, y ) - point_vec;
+         vec3 top_right_vec = getPoint( x + 1, y - 1 ) - point_vec;
+         estimated_normal += cross( right_vec, top_right_vec );
+         estimated_normal += cross( top_right_vec, top_vec );
+      }
+   }
+
+   if (y < WavePointNumSize.y - 1) {
+      vec3 bottom_vec = getPoint( x, y + 1 ) - point_vec;
+      if (x > 0) {
+         vec3 left_vec = getPoint( x - 1, y ) - point_vec;
+         vec3 bottom_left_vec = getPoint( x - 1, y + 1 ) - point_vec;
+         estimated_normal += cross( left_vec, bottom_left_vec );
+         estimated_normal += cross( bottom_left_vec, bottom_vec );
+      }
+      if (x < WavePointNumSize.x - 1) {
+         vec3 right_vec = getPoint( x + 1, y ) - point_vec;
+         vec3 bottom_right_vec = getPoint( x + 1, y + 1 ) - point_vec;
+         estimated_normal += cross( bottom_vec, bottom_right_vec );
+         estimated_normal += cross( bottom_right_vec, right_vec );
+      }
+   }
+   return normalize( estimated_normal );
+}
+
+void main()
+{   
+   ivec2 point = ivec2(gl_VertexID % WavePointNumSize.x, gl_VertexID / WavePointNumSize.x);
+   vec3 v_position = getPoint( point.x, point.y );
+   vec3 v_normal = getNormal( point.x, point.y, v_position );
+
+   vec4 e_position = ViewMatrix * WorldMatrix * vec4(v_position, 1.0f);
+   position_in_ec = e_position.xyz;
+   normal_in_ec = normalize( NormalMatrix * v_normal );
+
+   tex_coord = vec2(point) / vec2(WavePointNumSize - 1);
+
+   gl_Position = ModelViewProjectionMatrix * vec4(v_position, 1.0f);
+}
\ No newline at end of file
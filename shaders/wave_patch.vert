@@ -0,0 +1,14 @@
+#version 450
+
+uniform ivec2 WavePointNumSize;
+uniform int PatchSize;
+
+// corners of the coarse patch grid, in grid points. the last row and column of patches are cut at the grid border.
+out vec2 patch_corner;
+
+void main()
+{   
+   const int corner_num_x = (WavePointNumSize.x - 2) / PatchSize + 2;
+   ivec2 corner = ivec2(gl_VertexID % corner_num_x, gl_VertexID / corner_num_x);
+   patch_corner = vec2(min( corner * PatchSize, WavePointNumSize - 1 ));
+}
\ No newline at end of file
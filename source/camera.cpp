@@ -17,16 +17,22 @@ CameraGL::CameraGL(
    float near_plane,
    float far_plane
 ) : 
-   IsMoving( false ), Width( 0 ), Height( 0 ), FOV( fov ), InitFOV( fov ), NearPlane( near_plane ),
+   IsMoving( false ), CameraBufferDirty( true ), CameraBuffer( 0 ), Width( 0 ), Height( 0 ), FOV( fov ), InitFOV( fov ), NearPlane( near_plane ),
    FarPlane( far_plane ), AspectRatio( 0.0f ), ZoomSensitivity( 1.0f ), MoveSensitivity( 0.05f ),
    RotationSensitivity( 0.005f ), InitCamPos( cam_position ), InitRefPos( view_reference_position ),
    InitUpVec( view_up_vector ), CamPos( cam_position ), ViewMatrix( glm::lookAt( InitCamPos, InitRefPos, InitUpVec ) ),
-   ProjectionMatrix( glm::mat4(1.0f) )
+   ProjectionMatrix( glm::mat4(1.0f) ), CameraBufferWorldMatrix( glm::mat4(1.0f) )
 {
 }
 
+CameraGL::~CameraGL()
+{
+   if (CameraBuffer != 0) glDeleteBuffers( 1, &CameraBuffer );
+}
+
 void CameraGL::updateCamera()
 {
+   CameraBufferDirty = true;
    const glm::mat4 inverse_view = inverse( ViewMatrix );
    CamPos.x = inverse_view[3][0];
    CamPos.y = inverse_view[3][1];
@@ -101,6 +107,7 @@ void CameraGL::zoomIn()
    if (FOV > 0.0f) {
       FOV -= ZoomSensitivity;
       ProjectionMatrix = glm::perspective( glm::radians( FOV ), AspectRatio, NearPlane, FarPlane );
+      CameraBufferDirty = true;
    }
 }
 
@@ -109,6 +116,7 @@ void CameraGL::zoomOut()
    if (FOV < 90.0f) {
       FOV += ZoomSensitivity;
       ProjectionMatrix = glm::perspective( glm::radians( FOV ), AspectRatio, NearPlane, FarPlane );
+      CameraBufferDirty = true;
    }
 }
 
@@ -117,6 +125,7 @@ void CameraGL::resetCamera()
    CamPos = InitCamPos; 
    ViewMatrix = lookAt( InitCamPos, InitRefPos, InitUpVec );
    ProjectionMatrix = glm::perspective( glm::radians( InitFOV ), AspectRatio, NearPlane, FarPlane );
+   CameraBufferDirty = true;
 }
 
 void CameraGL::updateWindowSize(int width, int height)
@@ -125,4 +134,26 @@ void CameraGL::updateWindowSize(int width, int height)
    Height = height;
    AspectRatio = static_cast<float>(width) / static_cast<float>(height);
    ProjectionMatrix = glm::perspective( glm::radians( FOV ), AspectRatio, NearPlane, FarPlane );
+   CameraBufferDirty = true;
+}
+
+void CameraGL::transferCameraBuffer(const glm::mat4& to_world)
+{
+   // the matrices of CameraBlock in the scene shaders, in their std140 order.
+   if (CameraBuffer == 0) {
+      glCreateBuffers( 1, &CameraBuffer );
+      glNamedBufferStorage( CameraBuffer, sizeof( glm::mat4 ) * 5, nullptr, GL_DYNAMIC_STORAGE_BIT );
+   }
+   if (CameraBufferDirty || to_world != CameraBufferWorldMatrix) {
+      // std140 lays the columns of the mat3 NormalMatrix out as vec4s, which are the first three columns of a mat4.
+      const glm::mat4 model_view = ViewMatrix * to_world;
+      const std::array<glm::mat4, 5> matrices{
+         to_world, ViewMatrix, ProjectionMatrix, ProjectionMatrix * model_view,
+         glm::mat4(glm::transpose( glm::inverse( glm::mat3(model_view) ) ))
+      };
+      glNamedBufferSubData( CameraBuffer, 0, sizeof( matrices ), matrices.data() );
+      CameraBufferWorldMatrix = to_world;
+      CameraBufferDirty = false;
+   }
+   glBindBufferBase( GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, CameraBuffer );
 }
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "cpu_profiler.h"
+
+CPUProfiler::ThreadRingOwner::~ThreadRingOwner()
+{
+   if (Ring == nullptr) return;
+   std::lock_guard<std::mutex> lock( RingLock );
+   Ring->Owned = false;
+}
+
+CPUProfiler::ThreadRingOwner& CPUProfiler::getThreadRingOwner()
+{
+   thread_local ThreadRingOwner owner;
+   return owner;
+}
+
+CPUProfiler::ThreadRing* CPUProfiler::getThreadRing()
+{
+   // the rings outlive their threads, so the zones of a joined thread can still be exported.
+   ThreadRingOwner& owner = getThreadRingOwner();
+   if (owner.Ring == nullptr) {
+      std::lock_guard<std::mutex> lock( RingLock );
+      if (owner.ThreadName != nullptr) {
+         for (const auto& ring : Rings) {
+            if (!ring->Owned && ring->ThreadName != nullptr && std::strcmp( ring->ThreadName, owner.ThreadName ) == 0) {
+               owner.Ring = ring.get();
+               break;
+            }
+         }
+      }
+      if (owner.Ring == nullptr) {
+         auto new_ring = std::make_unique<ThreadRing>();
+         new_ring->ThreadName = owner.ThreadName;
+         new_ring->Zones = std::make_unique<ZoneSlot[]>( RingZoneNum );
+         new_ring->StartedZoneNum.store( 0, std::memory_order_relaxed );
+         new_ring->ZoneNum.store( 0, std::memory_order_relaxed );
+         owner.Ring = new_ring.get();
+         Rings.emplace_back( std::move( new_ring ) );
+      }
+      owner.Ring->Owned = true;
+   }
+   return owner.Ring;
+}
+
+void CPUProfiler::setThreadName(const char* thread_name)
+{
+   ThreadRingOwner& owner = getThreadRingOwner();
+   owner.ThreadName = thread_name;
+   if (owner.Ring != nullptr) {
+      std::lock_guard<std::mutex> lock( RingLock );
+      owner.Ring->ThreadName = thread_name;
+   }
+}
+
+void CPUProfiler::record(const char* name, int64_t frame, int64_t begin_time)
+{
+   ThreadRing* ring = getThreadRing();
+   const uint64_t zone_num = ring->ZoneNum.load( std::memory_order_relaxed );
+   ring->StartedZoneNum.store( zone_num + 1, std::memory_order_relaxed );
+   std::atomic_thread_fence( std::memory_order_release );
+
+   ZoneSlot& slot = ring->Zones[zone_num % RingZoneNum];
+   slot.Name.store( name, std::memory_order_relaxed );
+   slot.Frame.store( frame, std::memory_order_relaxed );
+   slot.BeginTime.store( begin_time, std::memory_order_relaxed );
+   slot.EndTime.store( getTime(), std::memory_order_relaxed );
+   ring->ZoneNum.store( zone_num + 1, std::memory_order_release );
+}
+
+bool CPUProfiler::exportChromeTrace(const std::string& file_path, int64_t first_frame, int64_t last_frame)
+{
+   std::ofstream file( file_path );
+   if (!file.is_open()) return false;
+
+   std::lock_guard<std::mutex> lock( RingLock );
+   file << std::fixed << std::setprecision( 3 );
+   file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+   bool first_event = true;
+   for (size_t thread_id = 0; thread_id < Rings.size(); ++thread_id) {
+      const ThreadRing* ring = Rings[thread_id].get();
+      if (ring->ThreadName != nullptr) {
+         file << (first_event ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread_id
+            << ",\"args\":{\"name\":\"" << ring->ThreadName << "\"}}";
+         first_event = false;
+      }
+
+      // the thread may go on writing while its ring is copied. zone i shares its slot with zone i + RingZoneNum,
+      // so the zones whose slot a write has started on meanwhile are dropped.
+      const uint64_t zone_num = ring->ZoneNum.load( std::memory_order_acquire );
+      const uint64_t oldest_zone = zone_num > RingZoneNum ? zone_num - RingZoneNum : 0;
+      std::vector<Zone> zones;
+      zones.reserve( zone_num - oldest_zone );
+      for (uint64_t i = oldest_zone; i < zone_num; ++i) {
+         const ZoneSlot& slot = ring->Zones[i % RingZoneNum];
+         zones.push_back(
+            {
+               slot.Name.load( std::memory_order_relaxed ),
+               slot.Frame.load( std::memory_order_relaxed ),
+               slot.BeginTime.load( std::memory_order_relaxed ),
+               slot.EndTime.load( std::memory_order_relaxed )
+            }
+         );
+      }
+      std::atomic_thread_fence( std::memory_order_acquire );
+      const uint64_t started_zone_num = ring->StartedZoneNum.load( std::memory_order_relaxed );
+      const uint64_t overwritten_num = started_zone_num > RingZoneNum ? started_zone_num - RingZoneNum : 0;
+      const size_t valid_start = overwritten_num > oldest_zone ? overwritten_num - oldest_zone : 0;
+
+      for (size_t i = std::min( valid_start, zones.size() ); i < zones.size(); ++i) {
+         const Zone& zone = zones[i];
+         if (zone.Frame < first_frame || zone.Frame > last_frame) continue;
+
+         file << (first_event ? "\n" : ",\n") << "{\"name\":\"" << zone.Name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+            << thread_id << ",\"ts\":" << static_cast<double>(zone.BeginTime) * 1e-3
+            << ",\"dur\":" << static_cast<double>(zone.EndTime - zone.BeginTime) * 1e-3
+            << ",\"args\":{\"frame\":" << zone.Frame << "}}";
+         first_event = false;
+      }
+   }
+   file << "\n]}\n";
+   return file.good();
+}
\ No newline at end of file
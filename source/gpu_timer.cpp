@@ -0,0 +1,142 @@
+#include "gpu_timer.h"
+
+GPUTimerGL::GPUTimerGL(std::vector<std::string> pass_names, int frame_latency) :
+   Enabled( false ), FrameIndex( -1 ), SkippedFrameNum( 0 ), PassNames( std::move( pass_names ) ),
+   Slots( frame_latency ), PassTimes( PassNames.size() ), PassTimeNums( PassNames.size(), 0 )
+{
+   for (auto& slot : Slots) {
+      slot.FrameIndex = -1;
+      slot.Queries.resize( PassNames.size() );
+      slot.Issued.resize( PassNames.size(), false );
+      for (auto& queries : slot.Queries) glCreateQueries( GL_TIMESTAMP, 2, queries.data() );
+   }
+}
+
+GPUTimerGL::~GPUTimerGL()
+{
+   for (auto& slot : Slots) {
+      for (auto& queries : slot.Queries) glDeleteQueries( 2, queries.data() );
+   }
+}
+
+void GPUTimerGL::setEnabled(bool enabled)
+{
+   // the slots of the frames before a pause would be read as if they were recent, so they are dropped.
+   if (Enabled == enabled) return;
+
+   Enabled = enabled;
+   for (auto& slot : Slots) std::fill( slot.Issued.begin(), slot.Issued.end(), false );
+   std::fill( PassTimeNums.begin(), PassTimeNums.end(), 0 );
+}
+
+bool GPUTimerGL::setCSVFile(const std::string& file_path)
+{
+   CSVFile.open( file_path );
+   if (!CSVFile.is_open()) return false;
+
+   CSVFile << "frame";
+   for (const auto& name : PassNames) CSVFile << "," << name << "_ms";
+   CSVFile << "\n";
+   return true;
+}
+
+void GPUTimerGL::beginFrame()
+{
+   if (!Enabled) return;
+
+   FrameIndex++;
+   FrameSlot& slot = getCurrentSlot();
+   collect( slot, false );
+   slot.FrameIndex = FrameIndex;
+   std::fill( slot.Issued.begin(), slot.Issued.end(), false );
+}
+
+void GPUTimerGL::begin(int pass)
+{
+   if (!Enabled || FrameIndex < 0) return;
+
+   FrameSlot& slot = getCurrentSlot();
+   glQueryCounter( slot.Queries[pass][0], GL_TIMESTAMP );
+}
+
+void GPUTimerGL::end(int pass)
+{
+   if (!Enabled || FrameIndex < 0) return;
+
+   FrameSlot& slot = getCurrentSlot();
+   glQueryCounter( slot.Queries[pass][1], GL_TIMESTAMP );
+   slot.Issued[pass] = true;
+}
+
+void GPUTimerGL::flush()
+{
+   if (!Enabled) return;
+
+   // the pending frames are collected from the oldest on, so that the CSV rows stay in frame order.
+   const auto slot_num = static_cast<int64_t>(Slots.size());
+   for (int64_t frame = std::max( FrameIndex - slot_num + 1, int64_t{ 0 } ); frame <= FrameIndex; ++frame) {
+      FrameSlot& slot = Slots[frame % slot_num];
+      if (slot.FrameIndex == frame) collect( slot, true );
+   }
+}
+
+void GPUTimerGL::collect(FrameSlot& slot, bool wait)
+{
+   bool issued = false;
+   for (const bool pass_issued : slot.Issued) issued = issued || pass_issued;
+   if (!issued) return;
+
+   // the end timestamps are written in submission order, so the last pass of the frame becomes available last.
+   bool available = true;
+   for (size_t pass = 0; !wait && available && pass < PassNames.size(); ++pass) {
+      if (!slot.Issued[pass]) continue;
+
+      GLint pass_available = GL_FALSE;
+      glGetQueryObjectiv( slot.Queries[pass][1], GL_QUERY_RESULT_AVAILABLE, &pass_available );
+      available = pass_available != GL_FALSE;
+   }
+   if (!available) SkippedFrameNum++;
+
+   if (CSVFile.is_open()) CSVFile << slot.FrameIndex;
+   for (size_t pass = 0; pass < PassNames.size(); ++pass) {
+      if (!available || !slot.Issued[pass]) {
+         if (CSVFile.is_open()) CSVFile << ",";
+         continue;
+      }
+
+      GLuint64 begin_time = 0;
+      GLuint64 end_time = 0;
+      glGetQueryObjectui64v( slot.Queries[pass][0], GL_QUERY_RESULT, &begin_time );
+      glGetQueryObjectui64v( slot.Queries[pass][1], GL_QUERY_RESULT, &end_time );
+      const double milliseconds = static_cast<double>(end_time - begin_time) * 1e-6;
+      PassTimes[pass][PassTimeNums[pass] % AverageFrameNum] = milliseconds;
+      PassTimeNums[pass]++;
+      if (CSVFile.is_open()) CSVFile << "," << milliseconds;
+   }
+   if (CSVFile.is_open()) CSVFile << "\n";
+   std::fill( slot.Issued.begin(), slot.Issued.end(), false );
+}
+
+double GPUTimerGL::getAverageTime(int pass) const
+{
+   const int time_num = std::min( PassTimeNums[pass], AverageFrameNum );
+   if (time_num == 0) return -1.0;
+
+   double sum = 0.0;
+   for (int i = 0; i < time_num; ++i) sum += PassTimes[pass][i];
+   return sum / static_cast<double>(time_num);
+}
+
+std::string GPUTimerGL::getAverageTimeString() const
+{
+   std::ostringstream times;
+   times << std::fixed << std::setprecision( 3 );
+   for (size_t pass = 0; pass < PassNames.size(); ++pass) {
+      const double milliseconds = getAverageTime( static_cast<int>(pass) );
+      if (milliseconds < 0.0) continue;
+
+      if (times.tellp() > 0) times << ", ";
+      times << PassNames[pass] << " " << milliseconds << " ms";
+   }
+   return times.str();
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "headless_context.h"
+
+HeadlessContextGL::HeadlessContextGL() :
+   Width( 0 ), Height( 0 ), FBO( 0 ), ColorBuffer( 0 ), DepthBuffer( 0 )
+#ifdef WAVE_HEADLESS_EGL
+   , Display( EGL_NO_DISPLAY ), Context( EGL_NO_CONTEXT )
+#endif
+{
+}
+
+HeadlessContextGL::~HeadlessContextGL()
+{
+   if (DepthBuffer != 0) glDeleteRenderbuffers( 1, &DepthBuffer );
+   if (ColorBuffer != 0) glDeleteRenderbuffers( 1, &ColorBuffer );
+   if (FBO != 0) glDeleteFramebuffers( 1, &FBO );
+#ifdef WAVE_HEADLESS_EGL
+   if (Display != EGL_NO_DISPLAY) {
+      eglMakeCurrent( Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT );
+      if (Context != EGL_NO_CONTEXT) eglDestroyContext( Display, Context );
+      eglTerminate( Display );
+   }
+#endif
+}
+
+bool HeadlessContextGL::initialize(int width, int height)
+{
+#ifdef WAVE_HEADLESS_EGL
+   // the surfaceless platform needs neither a display server nor a GPU device.
+   const auto get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress( "eglGetPlatformDisplayEXT" ));
+   if (get_platform_display == nullptr) return false;
+
+   Display = get_platform_display( EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr );
+   if (Display == EGL_NO_DISPLAY || eglInitialize( Display, nullptr, nullptr ) == EGL_FALSE) return false;
+   if (eglBindAPI( EGL_OPENGL_API ) == EGL_FALSE) return false;
+
+   // llvmpipe stops at 4.5, which has everything the shaders use.
+   const std::array<EGLint, 7> context_attributes{
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, 5,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+   };
+   Context = eglCreateContext( Display, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, context_attributes.data() );
+   if (Context == EGL_NO_CONTEXT) return false;
+   if (eglMakeCurrent( Display, EGL_NO_SURFACE, EGL_NO_SURFACE, Context ) == EGL_FALSE) return false;
+   if (!gladLoadGLLoader( (GLADloadproc)eglGetProcAddress )) return false;
+
+   Width = width;
+   Height = height;
+   glCreateRenderbuffers( 1, &ColorBuffer );
+   glNamedRenderbufferStorage( ColorBuffer, GL_RGBA8, Width, Height );
+   glCreateRenderbuffers( 1, &DepthBuffer );
+   glNamedRenderbufferStorage( DepthBuffer, GL_DEPTH_COMPONENT24, Width, Height );
+   glCreateFramebuffers( 1, &FBO );
+   glNamedFramebufferRenderbuffer( FBO, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ColorBuffer );
+   glNamedFramebufferRenderbuffer( FBO, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, DepthBuffer );
+   if (glCheckNamedFramebufferStatus( FBO, GL_FRAMEBUFFER ) != GL_FRAMEBUFFER_COMPLETE) return false;
+
+   // there is no default framebuffer, so the FBO stays bound and the viewport has no window size to start from.
+   glBindFramebuffer( GL_FRAMEBUFFER, FBO );
+   glViewport( 0, 0, Width, Height );
+   return true;
+#else
+   static_cast<void>(width);
+   static_cast<void>(height);
+   return false;
+#endif
+}
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include "light.h"
 
 LightGL::LightGL() :
-   TurnLightOn( true ), GlobalAmbientColor( 0.2f, 0.2f, 0.2f, 1.0f ), TotalLightNum( 0 )
+   TurnLightOn( true ), LightBufferDirty( true ), LightBuffer( 0 ), LightBufferViewMatrix( 1.0f ), TotalLightNum( 0 ),
+   GlobalAmbientColor( 0.2f, 0.2f, 0.2f, 1.0f )
 {
 }
 
+LightGL::~LightGL()
+{
+   if (LightBuffer != 0) glDeleteBuffers( 1, &LightBuffer );
+}
+
 bool LightGL::isLightOn() const
 {
    return TurnLightOn;
@@ -13,6 +19,7 @@ bool LightGL::isLightOn() const
 void LightGL::toggleLightSwitch()
 {
    TurnLightOn = !TurnLightOn;
+   LightBufferDirty = true;
 }
 
 void LightGL::addLight(
@@ -40,35 +47,63 @@ void LightGL::addLight(
    IsActivated.emplace_back( true );
 
    TotalLightNum = static_cast<int>(Positions.size());
+   LightBufferDirty = true;
 }
 
 void LightGL::activateLight(const int& light_index)
 {
    if (light_index >= TotalLightNum) return;
    IsActivated[light_index] = true;
+   LightBufferDirty = true;
 }
 
 void LightGL::deactivateLight(const int& light_index)
 {
    if (light_index >= TotalLightNum) return;
    IsActivated[light_index] = false;
+   LightBufferDirty = true;
 }
 
-void LightGL::transferUniformsToShader(const ShaderGL* shader)
+LightGL::LightInfo LightGL::getLightInfo(
+   int light_index,
+   const glm::mat4& view_matrix,
+   const glm::mat3& normal_matrix
+) const
 {
-   glUniform1i( shader->getLightAvailabilityLocation(), TurnLightOn ? 1 : 0 );
-   glUniform1i( shader->getLightNumLocation(), static_cast<GLint>(TotalLightNum) );
-   glUniform4fv( shader->getGlobalAmbientLocation(), 1, &GlobalAmbientColor[0] );
+   // a spotlight factor is one inside the inner cone, falls off over the feathered rim and is zero outside the cutoff.
+   // a light of 180 degrees or more is no spotlight at all, so both cosines let every direction through.
+   const float cutoff_angle_in_degree = SpotlightCutoffAngles[light_index];
+   const float cutoff_angle = glm::radians( std::clamp( cutoff_angle_in_degree, 0.0f, 90.0f ) );
+   const float inner_cutoff_angle = cutoff_angle * (1.0f - SpotlightFeathers[light_index]);
+   const bool spotlight = cutoff_angle_in_degree < 180.0f;
+   return {
+      view_matrix * Positions[light_index], AmbientColors[light_index], DiffuseColors[light_index],
+      SpecularColors[light_index], glm::normalize( normal_matrix * SpotlightDirections[light_index] ), cutoff_angle,
+      IsActivated[light_index] ? 1 : 0, SpotlightFeathers[light_index], FallOffRadii[light_index],
+      spotlight ? std::cos( inner_cutoff_angle ) : -1.0f, spotlight ? std::cos( cutoff_angle ) : -1.0f, {}
+   };
+}
 
-   for (int i = 0; i < TotalLightNum; ++i) {
-      glUniform1i( shader->getLightSwitchLocation( i ), IsActivated[0] ? 1 : 0 );
-      glUniform4fv( shader->getLightPositionLocation( i ), 1, &Positions[i][0] );
-      glUniform4fv( shader->getLightAmbientLocation( i ), 1, &AmbientColors[i][0] );
-      glUniform4fv( shader->getLightDiffuseLocation( i ), 1, &DiffuseColors[i][0] );
-      glUniform4fv( shader->getLightSpecularLocation( i ), 1, &SpecularColors[i][0] );
-      glUniform3fv( shader->getLightSpotlightDirectionLocation( i ), 1, &SpotlightDirections[i][0] );
-      glUniform1f( shader->getLightSpotlightCutoffAngleLocation( i ), SpotlightCutoffAngles[i] );
-      glUniform1f( shader->getLightSpotlightFeatherLocation( i ), SpotlightFeathers[i] );
-      glUniform1f( shader->getLightFallOffRadiusLocation( i ), FallOffRadii[i] );
+void LightGL::transferLightBuffer(const glm::mat4& view_matrix)
+{
+   const CPUZone zone( "LightGL::transferLightBuffer" );
+   if (LightBuffer == 0) {
+      glCreateBuffers( 1, &LightBuffer );
+      glNamedBufferStorage( LightBuffer, sizeof( LightBlock ), nullptr, GL_DYNAMIC_STORAGE_BIT );
+   }
+   if (LightBufferDirty || view_matrix != LightBufferViewMatrix) {
+      // only the lights in use are uploaded, so the range grows with the light number rather than MaxLightNum.
+      const int light_num = std::min( TotalLightNum, MaxLightNum );
+      const glm::mat3 normal_matrix = glm::transpose( glm::inverse( glm::mat3(view_matrix) ) );
+      LightBlock block{};
+      block.UseLight = TurnLightOn ? 1 : 0;
+      block.LightNum = light_num;
+      block.GlobalAmbient = GlobalAmbientColor;
+      for (int i = 0; i < light_num; ++i) block.Lights[i] = getLightInfo( i, view_matrix, normal_matrix );
+      const auto block_size = static_cast<GLsizeiptr>(offsetof( LightBlock, Lights ) + sizeof( LightInfo ) * light_num);
+      glNamedBufferSubData( LightBuffer, 0, block_size, &block );
+      LightBufferViewMatrix = view_matrix;
+      LightBufferDirty = false;
    }
+   glBindBufferBase( GL_UNIFORM_BUFFER, LIGHT_BLOCK_BINDING, LightBuffer );
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include "object.h"
 
 ObjectGL::ObjectGL() :
-   VAO( 0 ), VBO( 0 ), IBO( 0 ), DrawMode( 0 ), VerticesCount( 0 ), WaveBuffers{},
-   EmissionColor( 0.0f, 0.0f, 0.0f, 1.0f ), AmbientReflectionColor( 0.2f, 0.2f, 0.2f, 1.0f ),
+   VAO( 0 ), VBO( 0 ), IBO( 0 ), DrawMode( 0 ), VerticesCount( 0 ), WaveSpareBuffer( 0 ), WaveSurfaceBuffer( 0 ),
+   WaveChunkIBO( 0 ), WaveChunkBuffer( 0 ), WaveChunkCommandBuffer( 0 ), WaveChunkNum( 0 ), WaveClipmapLevelNum( 0 ),
+   WaveClipmapIndexOffsets{}, WaveBuffers{}, WaveImages{}, WaveReadbackRequestNum( 0 ), MaterialBufferDirty( true ),
+   MaterialBuffer( 0 ), EmissionColor( 0.0f, 0.0f, 0.0f, 1.0f ), AmbientReflectionColor( 0.2f, 0.2f, 0.2f, 1.0f ),
    DiffuseReflectionColor( 0.8f, 0.8f, 0.8f, 1.0f ), SpecularReflectionColor( 0.0f, 0.0f, 0.0f, 1.0f ),
-   SpecularReflectionExponent( 0.0f ), WaveFactor( 10.0f )
+   SpecularReflectionExponent( 0.0f ), WaveFactor( 0.0f ), WaveGridStep( 0.0f, 0.0f ),
+   WavePointNumSize( 0, 0 )
 {
 }
 
@@ -13,6 +16,10 @@ ObjectGL::~ObjectGL()
    if (IBO != 0) glDeleteBuffers( 1, &IBO );
    if (VBO != 0) glDeleteBuffers( 1, &VBO );
    if (VAO != 0) glDeleteVertexArrays( 1, &VAO );
+   if (MaterialBuffer != 0) glDeleteBuffers( 1, &MaterialBuffer );
+   for (const auto& slot : WaveReadbackSlots) {
+      if (slot.Fence != nullptr) glDeleteSync( slot.Fence );
+   }
    for (const auto& texture_id : TextureID) {
       if (texture_id != 0) glDeleteTextures( 1, &texture_id );
    }
@@ -24,26 +31,31 @@ ObjectGL::~ObjectGL()
 void ObjectGL::setEmissionColor(const glm::vec4& emission_color)
 {
    EmissionColor = emission_color;
+   MaterialBufferDirty = true;
 }
 
 void ObjectGL::setAmbientReflectionColor(const glm::vec4& ambient_reflection_color)
 {
    AmbientReflectionColor = ambient_reflection_color;
+   MaterialBufferDirty = true;
 }
 
 void ObjectGL::setDiffuseReflectionColor(const glm::vec4& diffuse_reflection_color)
 {
    DiffuseReflectionColor = diffuse_reflection_color;
+   MaterialBufferDirty = true;
 }
 
 void ObjectGL::setSpecularReflectionColor(const glm::vec4& specular_reflection_color)
 {
    SpecularReflectionColor = specular_reflection_color;
+   MaterialBufferDirty = true;
 }
 
 void ObjectGL::setSpecularReflectionExponent(const float& specular_reflection_exponent)
 {
    SpecularReflectionExponent = specular_reflection_exponent;
+   MaterialBufferDirty = true;
 }
 
 bool ObjectGL::prepareTexture2DUsingFreeImage(const std::string& file_path, bool is_grayscale) const
@@ -161,6 +173,104 @@ void ObjectGL::prepareIndexBuffer()
    glVertexArrayElementBuffer( VAO, IBO );
 }
 
+void ObjectGL::prepareWaveChunks(const glm::ivec2& wave_point_num_size)
+{
+   // every chunk covers WaveChunkSize x WaveChunkSize cells as rows of triangle strips of its own,
+   // so that a culling pass can draw any subset of chunks with one indirect multi-draw.
+   std::vector<GLuint> chunk_indices;
+   std::vector<WaveChunk> chunks;
+   for (int y = 0; y < wave_point_num_size.y - 1; y += WaveChunkSize) {
+      for (int x = 0; x < wave_point_num_size.x - 1; x += WaveChunkSize) {
+         WaveChunk chunk{};
+         chunk.PointMin = glm::ivec2(x, y);
+         chunk.PointMax = glm::min( chunk.PointMin + WaveChunkSize, wave_point_num_size - 1 );
+         chunk.FirstIndex = static_cast<GLuint>(chunk_indices.size());
+         for (int j = y; j < chunk.PointMax.y; ++j) {
+            if (j > y) chunk_indices.emplace_back( WaveRestartIndex );
+            for (int i = x; i <= chunk.PointMax.x; ++i) {
+               chunk_indices.emplace_back( (j + 1) * wave_point_num_size.x + i );
+               chunk_indices.emplace_back( j * wave_point_num_size.x + i );
+            }
+         }
+         chunk.IndexCount = static_cast<GLuint>(chunk_indices.size()) - chunk.FirstIndex;
+         chunks.emplace_back( chunk );
+      }
+   }
+   WaveChunkNum = static_cast<int>(chunks.size());
+
+   addCustomBufferObject<GLuint>( "wave_chunk_indices", static_cast<int>(chunk_indices.size()) );
+   WaveChunkIBO = getCustomBufferID( "wave_chunk_indices" );
+   glNamedBufferSubData(
+      WaveChunkIBO, 0,
+      static_cast<GLsizeiptr>(chunk_indices.size() * sizeof( GLuint )), chunk_indices.data()
+   );
+
+   addCustomBufferObject<WaveChunk>( "wave_chunks", WaveChunkNum );
+   WaveChunkBuffer = getCustomBufferID( "wave_chunks" );
+   glNamedBufferSubData( WaveChunkBuffer, 0, static_cast<GLsizeiptr>(chunks.size() * sizeof( WaveChunk )), chunks.data() );
+
+   // one DrawElementsIndirectCommand of five integers per chunk, written by wave_cull.comp.
+   addCustomBufferObject<GLuint>( "wave_chunk_commands", WaveChunkNum * 5 );
+   WaveChunkCommandBuffer = getCustomBufferID( "wave_chunk_commands" );
+}
+
+void ObjectGL::prepareWaveClipmap(const glm::ivec2& wave_point_num_size)
+{
+   // every level is a grid of WaveClipmapSize x WaveClipmapSize cells whose vertices wave_clipmap.vert places
+   // from gl_VertexID, so the same indices serve all levels and the vertex count does not depend on the domain.
+   constexpr int n = WaveClipmapSize;
+   VerticesCount = (n + 1) * (n + 1);
+   WaveClipmapLevelNum = 2;
+   while ((n << (WaveClipmapLevelNum - 2)) < std::max( wave_point_num_size.x, wave_point_num_size.y )) {
+      WaveClipmapLevelNum++;
+   }
+
+   const auto add_strips = [this](const glm::ivec2& hole_min, const glm::ivec2& hole_max) {
+      bool first_strip = true;
+      for (int j = 0; j < n; ++j) {
+         const bool hole_row = hole_min.y <= j && j < hole_max.y;
+         const std::array<glm::ivec2, 2> runs = hole_row ?
+            std::array<glm::ivec2, 2>{ glm::ivec2(0, hole_min.x), glm::ivec2(hole_max.x, n) } :
+            std::array<glm::ivec2, 2>{ glm::ivec2(0, n), glm::ivec2(n, n) };
+         for (const auto& run : runs) {
+            if (run.x == run.y) continue;
+            if (!first_strip) IndexBuffer.emplace_back( WaveRestartIndex );
+            for (int i = run.x; i <= run.y; ++i) {
+               IndexBuffer.emplace_back( (j + 1) * (n + 1) + i );
+               IndexBuffer.emplace_back( j * (n + 1) + i );
+            }
+            first_strip = false;
+         }
+      }
+
+      // the odd vertices of the outer edge lie on the edges of the coarser level only up to rounding,
+      // so a triangle through each of them and its two neighbours closes the pinholes along the T-junctions.
+      for (int k = 1; k < n; k += 2) {
+         const std::array<glm::ivec2, 4> edge_points{
+            glm::ivec2(k, 0), glm::ivec2(k, n), glm::ivec2(0, k), glm::ivec2(n, k)
+         };
+         for (int e = 0; e < 4; ++e) {
+            const glm::ivec2 along = e < 2 ? glm::ivec2(1, 0) : glm::ivec2(0, 1);
+            IndexBuffer.emplace_back( WaveRestartIndex );
+            for (const auto& point : { edge_points[e] - along, edge_points[e], edge_points[e] + along }) {
+               IndexBuffer.emplace_back( point.y * (n + 1) + point.x );
+            }
+         }
+      }
+   };
+
+   // the finest level has no hole. each coarser level leaves out the half of itself which the finer level covers,
+   // but the finer level is snapped to its own grid and so sits one coarse cell further along either axis or not.
+   WaveClipmapIndexOffsets[0] = 0;
+   add_strips( glm::ivec2(n), glm::ivec2(n) );
+   for (int k = 0; k < 4; ++k) {
+      WaveClipmapIndexOffsets[k + 1] = static_cast<GLuint>(IndexBuffer.size());
+      const glm::ivec2 hole_min = glm::ivec2(n / 4) + glm::ivec2(k & 1, k >> 1);
+      add_strips( hole_min, hole_min + n / 2 );
+   }
+   WaveClipmapIndexOffsets[5] = static_cast<GLuint>(IndexBuffer.size());
+}
+
 void ObjectGL::getSquareObject(
    std::vector<glm::vec3>& vertices,
    std::vector<glm::vec3>& normals,
@@ -320,79 +430,249 @@ void ObjectGL::setSquareObject(
    setObject( draw_mode, square_vertices, square_normals, square_textures, texture_file_path, is_grayscale );
 }
 
-void ObjectGL::setWaveObject(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size)
+void ObjectGL::prepareWaveLevelCopies(int copy_num)
+{
+   const bool height_images = WaveImages[0] != 0;
+   for (auto i = static_cast<int>(WaveLevelCopies.size()); i < copy_num; ++i) {
+      GLuint level = 0;
+      if (height_images) {
+         glCreateTextures( GL_TEXTURE_2D, 1, &level );
+         glTextureStorage2D( level, 1, GL_R32F, WavePointNumSize.x, WavePointNumSize.y );
+         glTextureParameteri( level, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+         glTextureParameteri( level, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+         glTextureParameteri( level, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+         glTextureParameteri( level, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+         TextureID.emplace_back( level );
+      }
+      else {
+         const std::string name = "wave_heights_copy" + std::to_string( i );
+         addCustomBufferObject<GLfloat>( name, WavePointNumSize.x * WavePointNumSize.y );
+         level = getCustomBufferID( name );
+      }
+      WaveLevelCopies.emplace_back( level );
+   }
+}
+
+void ObjectGL::copyWaveLevel(int index, int copy_index) const
+{
+   if (WaveImages[0] != 0) {
+      glCopyImageSubData(
+         WaveImages[index], GL_TEXTURE_2D, 0, 0, 0, 0,
+         WaveLevelCopies[copy_index], GL_TEXTURE_2D, 0, 0, 0, 0,
+         WavePointNumSize.x, WavePointNumSize.y, 1
+      );
+   }
+   else {
+      const auto level_size = static_cast<GLsizeiptr>(WavePointNumSize.x * WavePointNumSize.y * sizeof( GLfloat ));
+      glCopyNamedBufferSubData( WaveBuffers[index], WaveLevelCopies[copy_index], 0, 0, level_size );
+   }
+}
+
+void ObjectGL::prepareWaveReadback(int slot_num)
+{
+   // the buffers stay mapped for their whole life, so reading a finished slot needs neither a map nor a copy.
+   constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+   const auto level_size = static_cast<GLsizeiptr>(WavePointNumSize.x * WavePointNumSize.y * sizeof( GLfloat ));
+   for (auto i = static_cast<int>(WaveReadbackSlots.size()); i < slot_num; ++i) {
+      WaveReadbackSlot slot{ 0, nullptr, nullptr, -1 };
+      glCreateBuffers( 1, &slot.Buffer );
+      glNamedBufferStorage( slot.Buffer, level_size, nullptr, flags );
+      slot.Heights = static_cast<const GLfloat*>(glMapNamedBufferRange( slot.Buffer, 0, level_size, flags ));
+      CustomBuffers["wave_readback" + std::to_string( i )] = slot.Buffer;
+      WaveReadbackSlots.emplace_back( slot );
+   }
+}
+
+void ObjectGL::requestWaveReadback(GLuint level)
+{
+   // the slots are reused in turn, so a slot is overwritten only after all the others have been requested again.
+   WaveReadbackSlot& slot = WaveReadbackSlots[WaveReadbackRequestNum % WaveReadbackSlots.size()];
+   if (slot.Fence != nullptr) glDeleteSync( slot.Fence );
+
+   const auto level_size = static_cast<GLsizeiptr>(WavePointNumSize.x * WavePointNumSize.y * sizeof( GLfloat ));
+   if (WaveImages[0] != 0) {
+      glMemoryBarrier( GL_TEXTURE_UPDATE_BARRIER_BIT );
+      glBindBuffer( GL_PIXEL_PACK_BUFFER, slot.Buffer );
+      glGetTextureImage( level, 0, GL_RED, GL_FLOAT, static_cast<GLsizei>(level_size), nullptr );
+      glBindBuffer( GL_PIXEL_PACK_BUFFER, 0 );
+   }
+   else {
+      glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT );
+      glCopyNamedBufferSubData( level, slot.Buffer, 0, 0, level_size );
+   }
+   slot.Fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+   slot.RequestIndex = WaveReadbackRequestNum++;
+}
+
+const GLfloat* ObjectGL::getWaveReadback(int& request_age)
+{
+   // polls the fences without waiting, and returns the newest finished level or nullptr if none has finished yet.
+   // the heights stay valid until the next request.
+   const WaveReadbackSlot* newest = nullptr;
+   for (auto& slot : WaveReadbackSlots) {
+      if (slot.Fence != nullptr) {
+         const GLenum status = glClientWaitSync( slot.Fence, 0, 0 );
+         if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) continue;
+
+         glDeleteSync( slot.Fence );
+         slot.Fence = nullptr;
+      }
+      if (slot.RequestIndex >= 0 && (newest == nullptr || slot.RequestIndex > newest->RequestIndex)) newest = &slot;
+   }
+   if (newest == nullptr) return nullptr;
+
+   request_age = WaveReadbackRequestNum - 1 - newest->RequestIndex;
+   return newest->Heights;
+}
+
+void ObjectGL::setWaveObject(
+   const glm::ivec2& wave_point_num_size,
+   const glm::ivec2& wave_grid_size,
+   WaveRenderMode render_mode
+)
 {
+   const CPUZone zone( "ObjectGL::setWaveObject" );
    const float ds = 1.0f / static_cast<float>(wave_point_num_size.x - 1);
    const float dt = 1.0f / static_cast<float>(wave_point_num_size.y - 1);
-   const float dx = static_cast<float>(wave_grid_size.x) * ds;
-   const float dy = static_cast<float>(wave_grid_size.y) * dt;
-   const auto mid_x = static_cast<float>(wave_point_num_size.x >> 1);
-   const auto mid_y = static_cast<float>(wave_point_num_size.y >> 1);
-
-   constexpr float initial_radius_squared = 81.0f;
-   constexpr float initial_wave_factor = glm::pi<float>() / initial_radius_squared;
-   constexpr float initial_wave_height = 0.5f;
+   const glm::vec2 grid_step = WaveSolverCPU::getWaveGridStep( wave_point_num_size, wave_grid_size );
 
-   std::vector<glm::vec3> wave_vertices, wave_normals;
-   std::vector<glm::vec2> wave_textures;
+   // The simulation only touches the heights, so each time level is a tightly packed float buffer.
+   std::vector<GLfloat> wave_heights;
    for (int j = 0; j < wave_point_num_size.y; ++j) {
-      const auto y = static_cast<float>(j);
       for (int i = 0; i < wave_point_num_size.x; ++i) {
-         const auto x = static_cast<float>(i);
-         wave_vertices.emplace_back( x * dx, 0.0f, y * dy );
+         wave_heights.emplace_back( WaveSolverCPU::getInitialHeight( wave_point_num_size, i, j ) );
+      }
+   }
 
-         const float distance_squared = (x - mid_x) * (x - mid_x) + (y - mid_y) * (y - mid_y);
-         if (distance_squared <= initial_radius_squared) {
-            const float theta = std::sqrt( initial_wave_factor * distance_squared );
-            wave_vertices.back().y = initial_wave_height * (std::cos( theta ) + 1.0f);
+   const auto point_num = static_cast<int>(wave_heights.size());
+   const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
+   if (render_mode != WaveRenderMode::VertexAttributes) {
+      // The vertex shader rebuilds the static attributes from gl_VertexID,
+      // so the only render data is the height and normal which the normal estimation pass writes,
+      // or the height images themselves.
+      DrawMode = render_mode == WaveRenderMode::TessellatedImage ? GL_PATCHES : GL_TRIANGLE_STRIP;
+      VerticesCount = point_num;
+      glCreateVertexArrays( 1, &VAO );
+      addTexture( std::string(sample_directory_path + "/water.png") );
+      if (render_mode == WaveRenderMode::VertexPulling) {
+         addCustomBufferObject<glm::vec4>( "wave_surface", point_num );
+         WaveSurfaceBuffer = getCustomBufferID( "wave_surface" );
+      }
+   }
+   else {
+      // The vertex buffer is the render layout which the normal estimation pass derives from the latest level.
+      std::vector<glm::vec3> wave_vertices, wave_normals;
+      std::vector<glm::vec2> wave_textures;
+      for (int j = 0; j < wave_point_num_size.y; ++j) {
+         const auto y = static_cast<float>(j);
+         for (int i = 0; i < wave_point_num_size.x; ++i) {
+            const auto x = static_cast<float>(i);
+            wave_vertices.emplace_back( x * grid_step.x, wave_heights[j * wave_point_num_size.x + i], y * grid_step.y );
+            wave_normals.emplace_back( 0.0f, 0.0f, 0.0f );
+            wave_textures.emplace_back( x * ds, y * dt );
          }
-
-         wave_normals.emplace_back( 0.0f, 0.0f, 0.0f );
-         wave_textures.emplace_back( x * ds, y * dt );
       }
+      setObject(
+         GL_TRIANGLE_STRIP,
+         wave_vertices,
+         wave_normals,
+         wave_textures,
+         std::string(sample_directory_path + "/water.png")
+      );
    }
 
-   const std::string sample_directory_path = std::string(CMAKE_SOURCE_DIR) + "/samples";
-   setObject(
-      GL_TRIANGLE_STRIP,
-      wave_vertices,
-      wave_normals,
-      wave_textures,
-      std::string(sample_directory_path + "/water.png")
-   );
-   addCustomBufferObject<GLfloat>( "wave_buffer1", static_cast<int>(DataBuffer.size()) );
-   addCustomBufferObject<GLfloat>( "wave_buffer2", static_cast<int>(DataBuffer.size()) );
-   WaveBuffers[0] = VBO;
-   WaveBuffers[1] = getCustomBufferID( "wave_buffer1" );
-   WaveBuffers[2] = getCustomBufferID( "wave_buffer2" );
-   glNamedBufferSubData(
-      WaveBuffers[1], 0,
-      static_cast<GLsizei>(DataBuffer.size() * sizeof( GLfloat )),
-      DataBuffer.data()
-   );
+   if (render_mode == WaveRenderMode::HeightImage || render_mode == WaveRenderMode::TessellatedImage ||
+       render_mode == WaveRenderMode::ClipmapImage) {
+      // linear filtering lets a render mesh of another resolution sample the heights between the points.
+      for (int i = 0; i < 3; ++i) {
+         glCreateTextures( GL_TEXTURE_2D, 1, &WaveImages[i] );
+         glTextureStorage2D( WaveImages[i], 1, GL_R32F, wave_point_num_size.x, wave_point_num_size.y );
+         glTextureParameteri( WaveImages[i], GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+         glTextureParameteri( WaveImages[i], GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+         glTextureParameteri( WaveImages[i], GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+         glTextureParameteri( WaveImages[i], GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+         TextureID.emplace_back( WaveImages[i] );
+         if (i == 2) std::fill( wave_heights.begin(), wave_heights.end(), 0.0f );
+         glTextureSubImage2D(
+            WaveImages[i], 0, 0, 0,
+            wave_point_num_size.x, wave_point_num_size.y,
+            GL_RED, GL_FLOAT,
+            wave_heights.data()
+         );
+      }
+   }
+   else {
+      for (int i = 0; i < 3; ++i) {
+         const std::string name = "wave_heights" + std::to_string( i );
+         addCustomBufferObject<GLfloat>( name, point_num );
+         WaveBuffers[i] = getCustomBufferID( name );
+      }
+      const auto level_size = static_cast<GLsizeiptr>(point_num * sizeof( GLfloat ));
+      glNamedBufferSubData( WaveBuffers[0], 0, level_size, wave_heights.data() );
+      glNamedBufferSubData( WaveBuffers[1], 0, level_size, wave_heights.data() );
+      std::fill( wave_heights.begin(), wave_heights.end(), 0.0f );
+      glNamedBufferSubData( WaveBuffers[2], 0, level_size, wave_heights.data() );
+
+      // the substep kernel writes its two newest levels while the other groups still read the current two,
+      // so it needs one level more than a single step.
+      addCustomBufferObject<GLfloat>( "wave_heights_spare", point_num );
+      WaveSpareBuffer = getCustomBufferID( "wave_heights_spare" );
+   }
 
    IndexBuffer.clear();
-   for (int j = 0; j < wave_point_num_size.y - 1; ++j) {
-      for (int i = 0; i < wave_point_num_size.x; ++i) {
-         IndexBuffer.emplace_back( (j + 1) * wave_point_num_size.x + i );
-         IndexBuffer.emplace_back( j * wave_point_num_size.x + i );
+   if (render_mode == WaveRenderMode::TessellatedImage) {
+      // one quad patch per WavePatchSize x WavePatchSize cells, whose corners wave_patch.vert places on the grid.
+      const glm::ivec2 patch_num_size = (wave_point_num_size - 2) / WavePatchSize + 1;
+      const int corner_num_x = patch_num_size.x + 1;
+      VerticesCount = corner_num_x * (patch_num_size.y + 1);
+      for (int j = 0; j < patch_num_size.y; ++j) {
+         for (int i = 0; i < patch_num_size.x; ++i) {
+            IndexBuffer.emplace_back( j * corner_num_x + i );
+            IndexBuffer.emplace_back( j * corner_num_x + i + 1 );
+            IndexBuffer.emplace_back( (j + 1) * corner_num_x + i + 1 );
+            IndexBuffer.emplace_back( (j + 1) * corner_num_x + i );
+         }
+      }
+   }
+   else if (render_mode == WaveRenderMode::ClipmapImage) prepareWaveClipmap( wave_point_num_size );
+   else {
+      // GL_PRIMITIVE_RESTART_FIXED_INDEX treats the largest index as the restart index.
+      for (int j = 0; j < wave_point_num_size.y - 1; ++j) {
+         if (j > 0) IndexBuffer.emplace_back( WaveRestartIndex );
+         for (int i = 0; i < wave_point_num_size.x; ++i) {
+            IndexBuffer.emplace_back( (j + 1) * wave_point_num_size.x + i );
+            IndexBuffer.emplace_back( j * wave_point_num_size.x + i );
+         }
       }
    }
    prepareIndexBuffer();
+   if (render_mode != WaveRenderMode::TessellatedImage && render_mode != WaveRenderMode::ClipmapImage) {
+      prepareWaveChunks( wave_point_num_size );
+   }
 
    setDiffuseReflectionColor( { 0.0f, 0.47f, 0.75f, 1.0f } );
 
-   constexpr float delta_time = 0.0009f;
-   WaveFactor = WaveFactor * WaveFactor * delta_time * delta_time / dx;
+   WaveGridStep = grid_step;
+   WavePointNumSize = wave_point_num_size;
+   WaveFactor = WaveSolverCPU::getWaveFactor( grid_step.x );
 }
 
-void ObjectGL::transferUniformsToShader(const ShaderGL* shader)
+void ObjectGL::transferMaterialBuffer()
 {
-   glUniform4fv( shader->getMaterialEmissionLocation(), 1, &EmissionColor[0] );
-   glUniform4fv( shader->getMaterialAmbientLocation(), 1, &AmbientReflectionColor[0] );
-   glUniform4fv( shader->getMaterialDiffuseLocation(), 1, &DiffuseReflectionColor[0] );
-   glUniform4fv( shader->getMaterialSpecularLocation(), 1, &SpecularReflectionColor[0] );
-   glUniform1f( shader->getMaterialSpecularExponentLocation(), SpecularReflectionExponent );
+   const CPUZone zone( "ObjectGL::transferMaterialBuffer" );
+   if (MaterialBuffer == 0) {
+      glCreateBuffers( 1, &MaterialBuffer );
+      glNamedBufferStorage( MaterialBuffer, sizeof( MaterialBlock ), nullptr, GL_DYNAMIC_STORAGE_BIT );
+   }
+   if (MaterialBufferDirty) {
+      const MaterialBlock material{
+         EmissionColor, AmbientReflectionColor, DiffuseReflectionColor, SpecularReflectionColor,
+         SpecularReflectionExponent, {}
+      };
+      glNamedBufferSubData( MaterialBuffer, 0, sizeof( material ), &material );
+      MaterialBufferDirty = false;
+   }
+   glBindBufferBase( GL_UNIFORM_BUFFER, MATERIAL_BLOCK_BINDING, MaterialBuffer );
 }
 
 void ObjectGL::updateDataBuffer(const std::vector<glm::vec3>& vertices, const std::vector<glm::vec3>& normals)
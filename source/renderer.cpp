@@ -1,16 +1,31 @@
 #include "renderer.h"
 
-RendererGL::RendererGL() : 
-   Window( nullptr ), FrameWidth( 1920 ), FrameHeight( 1080 ), ActiveLightIndex( 0 ), WaveTargetIndex( 0 ),
+RendererGL::RendererGL(int headless_frame_num, int capture_interval) : 
+   Window( nullptr ), SimulationWindow( nullptr ), FrameWidth( 1920 ), FrameHeight( 1080 ),
+   HeadlessFrameNum( headless_frame_num ), CaptureInterval( capture_interval ), Initialized( false ),
+   ActiveLightIndex( 0 ),
+   WaveTargetIndex( 0 ), WaveDomainIndex( 0 ), RenderMode( WaveRenderMode::VertexAttributes ),
+   StepKernel( WaveStepKernel::Global ), SingleCallDraw( true ), ChunkCulling( true ), LevelInterpolation( true ),
+   ThreadedSimulation( false ), HeightReadback( false ), LatestPublishSlot( -1 ), ReadingPublishSlot( -1 ),
+   DrawSubmitFrameNum( 0 ), DrawSubmitTime( 0.0 ), ReadbackFrameNum( 0 ), ReadbackMissNum( 0 ),
+   ReadbackAgeSum( 0.0 ), ReadbackCenterHeight( 0.0f ), WaveLevelBlend( 1.0f ), TimingTitleTime{}, DrawnWaveLevels{},
+   WavePublishSlots{}, SimulationStopped( true ),
    WavePointNumSize( 100, 100 ), WaveGridSize( 5, 5 ), ClickedPoint( -1, -1 ),
-   MainCamera( std::make_unique<CameraGL>() ), ObjectShader( std::make_unique<ShaderGL>() ),
-   WaveShader( std::make_unique<ShaderGL>() ), WaveNormalShader( std::make_unique<ShaderGL>() ),
-   WaveObject( std::make_unique<ObjectGL>() ), Lights( std::make_unique<LightGL>() )
+   Headless( nullptr ), GPUTimer( nullptr ), MainCamera( std::make_unique<CameraGL>() ), ObjectShader( std::make_unique<ShaderGL>() ),
+   WaveShader( std::make_unique<ShaderGL>() ), WaveTiledShader( std::make_unique<ShaderGL>() ),
+   WaveFusedShader( std::make_unique<ShaderGL>() ), WaveBlockedShader( std::make_unique<ShaderGL>() ),
+   WaveImageShader( std::make_unique<ShaderGL>() ), WaveCullShader( std::make_unique<ShaderGL>() ),
+   WaveImageCullShader( std::make_unique<ShaderGL>() ), WaveNormalShader( std::make_unique<ShaderGL>() ),
+   WavePullingShader( std::make_unique<ShaderGL>() ), WavePullingNormalShader( std::make_unique<ShaderGL>() ),
+   WavePullingFusedShader( std::make_unique<ShaderGL>() ), WaveDisplacementShader( std::make_unique<ShaderGL>() ),
+   WaveTessellationShader( std::make_unique<ShaderGL>() ), WaveClipmapShader( std::make_unique<ShaderGL>() ),
+   WaveObject( std::make_unique<ObjectGL>() ), Lights( std::make_unique<LightGL>() ),
+   WaveClock( std::make_unique<SimulationClock>( WaveStepInterval, 4 ) )
 {
    Renderer = this;
 
-   initialize();
-   printOpenGLInformation();
+   Initialized = initialize();
+   if (Initialized) printOpenGLInformation();
 }
 
 void RendererGL::printOpenGLInformation()
@@ -23,29 +38,46 @@ void RendererGL::printOpenGLInformation()
    std::cout << "****************************************************************\n\n";
 }
 
-void RendererGL::initialize()
+bool RendererGL::initialize()
 {
-   if (!glfwInit()) {
-      std::cout << "Cannot Initialize OpenGL...\n";
-      return;
+   const CPUZone zone( "RendererGL::initialize" );
+   if (HeadlessFrameNum > 0) {
+      Headless = std::make_unique<HeadlessContextGL>();
+      if (!Headless->initialize( FrameWidth, FrameHeight )) {
+         std::cout << "Cannot Initialize Headless OpenGL...\n";
+         return false;
+      }
    }
-   glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
-   glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 6 );
-   glfwWindowHint( GLFW_DOUBLEBUFFER, GLFW_TRUE );
-   glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
+   else {
+      if (!glfwInit()) {
+         std::cout << "Cannot Initialize OpenGL...\n";
+         return false;
+      }
+      glfwWindowHint( GLFW_CONTEXT_VERSION_MAJOR, 4 );
+      glfwWindowHint( GLFW_CONTEXT_VERSION_MINOR, 6 );
+      glfwWindowHint( GLFW_DOUBLEBUFFER, GLFW_TRUE );
+      glfwWindowHint( GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE );
 
-   Window = glfwCreateWindow( FrameWidth, FrameHeight, "Main Camera", nullptr, nullptr );
-   glfwSetWindowUserPointer( Window, this );
-   glfwMakeContextCurrent( Window );
+      Window = glfwCreateWindow( FrameWidth, FrameHeight, "Main Camera", nullptr, nullptr );
+      if (Window == nullptr) {
+         std::cout << "Cannot Create the OpenGL Window...\n";
+         return false;
+      }
+      glfwSetWindowUserPointer( Window, this );
+      glfwMakeContextCurrent( Window );
 
-   if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-      std::cout << "Failed to initialize GLAD" << std::endl;
-      return;
+      if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+         std::cout << "Failed to initialize GLAD" << std::endl;
+         return false;
+      }
+
+      registerCallbacks();
    }
-   
-   registerCallbacks();
-   
+
+   GPUTimer = std::make_unique<GPUTimerGL>( std::vector<std::string>{ "step", "normal", "cull", "draw" } );
+
    glEnable( GL_DEPTH_TEST );
+   glEnable( GL_PRIMITIVE_RESTART_FIXED_INDEX );
    glClearColor( 1.0f, 1.0f, 1.0f, 1.0f );
 
    MainCamera->updateWindowSize( FrameWidth, FrameHeight );
@@ -56,7 +88,44 @@ void RendererGL::initialize()
       std::string(shader_directory_path + "/screen.frag").c_str()
    );
    WaveShader->setComputeShaders( std::string(shader_directory_path + "/wave.comp").c_str() );
+   WaveTiledShader->setComputeShaders( std::string(shader_directory_path + "/wave_tiled.comp").c_str() );
+   WaveFusedShader->setComputeShaders( std::string(shader_directory_path + "/wave_fused.comp").c_str() );
+   WaveBlockedShader->setComputeShaders( std::string(shader_directory_path + "/wave_blocked.comp").c_str() );
+   WaveImageShader->setComputeShaders( std::string(shader_directory_path + "/wave_image.comp").c_str() );
+   WaveCullShader->setComputeShaders( std::string(shader_directory_path + "/wave_cull.comp").c_str() );
+   WaveImageCullShader->setComputeShaders(
+      std::string(shader_directory_path + "/wave_cull.comp").c_str(),
+      { "WAVE_HEIGHT_IMAGE" }
+   );
    WaveNormalShader->setComputeShaders( std::string(shader_directory_path + "/wave_normal.comp").c_str() );
+   WavePullingShader->setShader(
+      std::string(shader_directory_path + "/wave.vert").c_str(),
+      std::string(shader_directory_path + "/screen.frag").c_str()
+   );
+   WavePullingNormalShader->setComputeShaders(
+      std::string(shader_directory_path + "/wave_normal.comp").c_str(),
+      { "WAVE_VERTEX_PULLING" }
+   );
+   WavePullingFusedShader->setComputeShaders(
+      std::string(shader_directory_path + "/wave_fused.comp").c_str(),
+      { "WAVE_VERTEX_PULLING" }
+   );
+   WaveDisplacementShader->setShader(
+      std::string(shader_directory_path + "/wave_displacement.vert").c_str(),
+      std::string(shader_directory_path + "/screen.frag").c_str()
+   );
+   WaveTessellationShader->setShader(
+      std::string(shader_directory_path + "/wave_patch.vert").c_str(),
+      std::string(shader_directory_path + "/screen.frag").c_str(),
+      nullptr,
+      std::string(shader_directory_path + "/wave_patch.tesc").c_str(),
+      std::string(shader_directory_path + "/wave_patch.tese").c_str()
+   );
+   WaveClipmapShader->setShader(
+      std::string(shader_directory_path + "/wave_clipmap.vert").c_str(),
+      std::string(shader_directory_path + "/screen.frag").c_str()
+   );
+   return true;
 }
 
 void RendererGL::cleanup(GLFWwindow* window)
@@ -74,6 +143,128 @@ void RendererGL::keyboard(GLFWwindow* window, int key, int scancode, int action,
          Renderer->Lights->toggleLightSwitch();
          std::cout << "Light Turned " << (Renderer->Lights->isLightOn() ? "On!\n" : "Off!\n");
          break;
+      case GLFW_KEY_V:
+         switch (Renderer->RenderMode) {
+            case WaveRenderMode::VertexAttributes:
+               Renderer->RenderMode = WaveRenderMode::VertexPulling;
+               std::cout << "Wave Render Mode: Vertex Pulling\n";
+               break;
+            case WaveRenderMode::VertexPulling:
+               Renderer->RenderMode = WaveRenderMode::HeightImage;
+               std::cout << "Wave Render Mode: Height Image\n";
+               break;
+            case WaveRenderMode::HeightImage:
+               Renderer->RenderMode = WaveRenderMode::TessellatedImage;
+               std::cout << "Wave Render Mode: Tessellated Image\n";
+               break;
+            case WaveRenderMode::TessellatedImage:
+               Renderer->RenderMode = WaveRenderMode::ClipmapImage;
+               std::cout << "Wave Render Mode: Clipmap Image\n";
+               break;
+            default:
+               Renderer->RenderMode = WaveRenderMode::VertexAttributes;
+               Renderer->setWaveDomainSize( 0 );
+               std::cout << "Wave Render Mode: Vertex Attributes\n";
+               break;
+         }
+         Renderer->setWaveObject();
+         break;
+      case GLFW_KEY_G:
+         if (Renderer->RenderMode != WaveRenderMode::ClipmapImage) {
+            std::cout << "Larger Wave Domains Need the Clipmap Render Mode\n";
+            break;
+         }
+         Renderer->setWaveDomainSize( (Renderer->WaveDomainIndex + 1) % static_cast<int>(WaveDomainSizes.size()) );
+         Renderer->setWaveObject();
+         std::cout << "Wave Domain: " << Renderer->WavePointNumSize.x << " x " << Renderer->WavePointNumSize.y << "\n";
+         break;
+      case GLFW_KEY_K:
+         // the simulation thread picks the kernel and the step budget up when it starts.
+         if (Renderer->ThreadedSimulation) Renderer->stopWaveThread();
+         switch (Renderer->StepKernel) {
+            case WaveStepKernel::Global:
+               Renderer->StepKernel = WaveStepKernel::Tiled;
+               std::cout << "Wave Step Kernel: Tiled\n";
+               break;
+            case WaveStepKernel::Tiled:
+               Renderer->StepKernel = WaveStepKernel::Fused;
+               std::cout << "Wave Step Kernel: Fused\n";
+               break;
+            default:
+               Renderer->StepKernel = WaveStepKernel::Global;
+               std::cout << "Wave Step Kernel: Global\n";
+               break;
+         }
+         if (Renderer->ThreadedSimulation) Renderer->startWaveThread();
+         break;
+      case GLFW_KEY_EQUAL:
+      case GLFW_KEY_MINUS: {
+         if (Renderer->ThreadedSimulation) Renderer->stopWaveThread();
+         const int max_step_num = Renderer->WaveClock->getMaxStepNum() + (key == GLFW_KEY_EQUAL ? 1 : -1);
+         Renderer->WaveClock->setMaxStepNum( std::clamp( max_step_num, 1, MaxWaveSubstepNum ) );
+         std::cout << "Max Wave Steps per Frame: " << Renderer->WaveClock->getMaxStepNum() << "\n";
+         if (Renderer->ThreadedSimulation) Renderer->startWaveThread();
+      } break;
+      case GLFW_KEY_T:
+         Renderer->LevelInterpolation = !Renderer->LevelInterpolation;
+         std::cout << "Wave Level Interpolation " << (Renderer->LevelInterpolation ? "On!\n" : "Off!\n");
+         if (!Renderer->ThreadedSimulation) {
+            std::cout << Renderer->WaveClock->getDroppedTime() << " s dropped over the step budget\n";
+         }
+         break;
+      case GLFW_KEY_M:
+         Renderer->ThreadedSimulation = !Renderer->ThreadedSimulation;
+         if (Renderer->ThreadedSimulation) Renderer->startWaveThread();
+         else Renderer->stopWaveThread();
+         std::cout << "Wave Simulation Thread " << (Renderer->ThreadedSimulation ? "On!\n" : "Off!\n");
+         break;
+      case GLFW_KEY_H:
+         if (Renderer->HeightReadback && Renderer->ReadbackFrameNum > 0) {
+            std::cout << "Wave Height Readback: center height " << Renderer->ReadbackCenterHeight << ", "
+               << Renderer->ReadbackAgeSum / Renderer->ReadbackFrameNum << " frames old on average over "
+               << Renderer->ReadbackFrameNum << " frames, " << Renderer->ReadbackMissNum << " frames without one\n";
+         }
+         Renderer->HeightReadback = !Renderer->HeightReadback;
+         if (Renderer->HeightReadback) Renderer->WaveObject->prepareWaveReadback( WaveReadbackSlotNum );
+         Renderer->ReadbackFrameNum = 0;
+         Renderer->ReadbackMissNum = 0;
+         Renderer->ReadbackAgeSum = 0.0;
+         std::cout << "Wave Height Readback " << (Renderer->HeightReadback ? "On!\n" : "Off!\n");
+         break;
+      case GLFW_KEY_O:
+         if (Renderer->GPUTimer->isEnabled()) {
+            std::cout << "GPU Pass Times: " << Renderer->GPUTimer->getAverageTimeString() << ", "
+               << Renderer->GPUTimer->getSkippedFrameNum() << " frames skipped\n";
+            glfwSetWindowTitle( Renderer->Window, "Main Camera" );
+         }
+         Renderer->GPUTimer->setEnabled( !Renderer->GPUTimer->isEnabled() );
+         std::cout << "GPU Pass Timing " << (Renderer->GPUTimer->isEnabled() ? "On!\n" : "Off!\n");
+         break;
+      case GLFW_KEY_F:
+         if (CPUProfiler::isEnabled()) {
+            if (CPUProfiler::exportChromeTrace( "wave_trace.json", 0, CPUProfiler::getFrameIndex() )) {
+               std::cout << "CPU Trace Saved: wave_trace.json\n";
+            }
+            else std::cout << "Cannot Save wave_trace.json\n";
+         }
+         CPUProfiler::setEnabled( !CPUProfiler::isEnabled() );
+         std::cout << "CPU Profiling " << (CPUProfiler::isEnabled() ? "On!\n" : "Off!\n");
+         break;
+      case GLFW_KEY_C:
+         Renderer->ChunkCulling = !Renderer->ChunkCulling;
+         std::cout << "Wave Chunk Culling " << (Renderer->ChunkCulling ? "On!\n" : "Off!\n");
+         break;
+      case GLFW_KEY_R:
+         if (Renderer->DrawSubmitFrameNum > 0) {
+            std::cout << (Renderer->SingleCallDraw ? "Single-Call" : "Per-Row") << " Draw Submission: "
+               << Renderer->DrawSubmitTime / Renderer->DrawSubmitFrameNum << " us/frame over "
+               << Renderer->DrawSubmitFrameNum << " frames\n";
+         }
+         Renderer->SingleCallDraw = !Renderer->SingleCallDraw;
+         Renderer->DrawSubmitFrameNum = 0;
+         Renderer->DrawSubmitTime = 0.0;
+         std::cout << "Wave Draw: " << (Renderer->SingleCallDraw ? "Single Call\n" : "Per Row\n");
+         break;
       case GLFW_KEY_P: {
          const glm::vec3 pos = Renderer->MainCamera->getCameraPosition();
          std::cout << "Camera Position: " << pos.x << ", " << pos.y << ", " << pos.z << "\n";
@@ -139,6 +330,7 @@ void RendererGL::registerCallbacks() const
 
 void RendererGL::setLights()
 {  
+   const CPUZone zone( "RendererGL::setLights" );
    const glm::vec4 light_position(50.0f, 500.0f, 50.0f, 1.0f);
    const glm::vec4 ambient_color(0.9f, 0.9f, 0.9f, 1.0f);
    const glm::vec4 diffuse_color(0.9f, 0.9f, 0.9f, 1.0f);
@@ -146,68 +338,566 @@ void RendererGL::setLights()
    Lights->addLight( light_position, ambient_color, diffuse_color, specular_color );
 }
 
-void RendererGL::drawWaveObject()
+void RendererGL::setWaveDomainSize(int domain_index)
+{
+   // the grid size grows with the point count, so the grid step and hence the wave factor stay as they are.
+   WaveDomainIndex = domain_index;
+   WavePointNumSize = glm::ivec2(WaveDomainSizes[domain_index]);
+   WaveGridSize = WavePointNumSize / 20;
+}
+
+void RendererGL::setWaveObject()
+{
+   const CPUZone zone( "RendererGL::setWaveObject" );
+   if (ThreadedSimulation) stopWaveThread();
+   WaveObject = std::make_unique<ObjectGL>();
+   WaveObject->setWaveObject( WavePointNumSize, WaveGridSize, RenderMode );
+   if (HeightReadback) WaveObject->prepareWaveReadback( WaveReadbackSlotNum );
+   WaveTargetIndex = 0;
+   WaveClock->reset();
+   if (ThreadedSimulation) startWaveThread();
+}
+
+void RendererGL::updateWaveImages(int step_num)
+{
+   // the image kernel has no shared-memory variants, so every substep is its own dispatch.
+   glUseProgram( WaveImageShader->getShaderProgram() );
+   glUniform1f( WaveImageShader->getLocation( Uniform::WaveFactor ), WaveObject->getWaveFactor() );
+   glUniform2iv( WaveImageShader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+   for (int s = 0; s < step_num; ++s) {
+      for (int i = 0; i < 3; ++i) {
+         glBindImageTexture(
+            i, WaveObject->getWaveImage( (WaveTargetIndex + i) % 3 ), 0, GL_FALSE, 0,
+            i < 2 ? GL_READ_ONLY : GL_WRITE_ONLY, GL_R32F
+         );
+      }
+      glDispatchCompute( getGroupSize( WavePointNumSize.x ), getGroupSize( WavePointNumSize.y ), 1 );
+      glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT );
+      WaveTargetIndex = (WaveTargetIndex + 1) % 3;
+   }
+}
+
+bool RendererGL::stepWave(int step_num, WaveStepKernel step_kernel)
 {
-   glUseProgram( WaveShader->getShaderProgram() );
-   glUniform1f( WaveShader->getLocation( "WaveFactor" ), WaveObject->getWaveFactor() );
-   glUniform2iv( WaveShader->getLocation( "WavePointNumSize" ), 1, &WavePointNumSize[0] );
-   
+   const CPUZone zone( "RendererGL::stepWave" );
+   if (RenderMode == WaveRenderMode::HeightImage || RenderMode == WaveRenderMode::TessellatedImage ||
+       RenderMode == WaveRenderMode::ClipmapImage) {
+      updateWaveImages( step_num );
+      return false;
+   }
+   if (step_num == 0) return false;
+
+   const bool vertex_pulling = RenderMode == WaveRenderMode::VertexPulling;
+   const GLuint surface_buffer = vertex_pulling ? WaveObject->getWaveSurfaceBuffer() : WaveObject->getVBO();
+   const GLbitfield surface_barrier = vertex_pulling ? GL_SHADER_STORAGE_BARRIER_BIT : GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, WaveObject->getWaveBuffer( WaveTargetIndex ) );
    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, WaveObject->getWaveBuffer( (WaveTargetIndex + 1) % 3 ) );
    glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, WaveObject->getWaveBuffer( (WaveTargetIndex + 2) % 3 ) );
-   glDispatchCompute( getGroupSize( WavePointNumSize.x ), getGroupSize( WavePointNumSize.y ), 1 );
-   glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
 
-   glUseProgram( WaveNormalShader->getShaderProgram() );
-   glUniform2iv( WaveNormalShader->getLocation( "WavePointNumSize" ), 1, &WavePointNumSize[0] );
+   if (step_num == 1 && step_kernel == WaveStepKernel::Fused) {
+      const ShaderGL* fused_shader = vertex_pulling ? WavePullingFusedShader.get() : WaveFusedShader.get();
+      glUseProgram( fused_shader->getShaderProgram() );
+      glUniform1f( fused_shader->getLocation( Uniform::WaveFactor ), WaveObject->getWaveFactor() );
+      glUniform2iv( fused_shader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+      glUniform2fv( fused_shader->getLocation( Uniform::WaveGridStep ), 1, &WaveObject->getWaveGridStep()[0] );
+      glUniform1f( fused_shader->getLocation( Uniform::WaveLevelBlend ), WaveLevelBlend );
+      glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, surface_buffer );
+      glDispatchCompute( getGroupSize( WavePointNumSize.x ), getGroupSize( WavePointNumSize.y ), 1 );
+      glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT | surface_barrier );
+      WaveTargetIndex = (WaveTargetIndex + 1) % 3;
+      return true;
+   }
+
+   if (step_num > 1) {
+      glUseProgram( WaveBlockedShader->getShaderProgram() );
+      glUniform1f( WaveBlockedShader->getLocation( Uniform::WaveFactor ), WaveObject->getWaveFactor() );
+      glUniform2iv( WaveBlockedShader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+      glUniform1i( WaveBlockedShader->getLocation( Uniform::SubstepNum ), step_num );
+      glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, WaveObject->getWaveSpareBuffer() );
+   }
+   else {
+      const ShaderGL* wave_shader = step_kernel == WaveStepKernel::Tiled ? WaveTiledShader.get() : WaveShader.get();
+      glUseProgram( wave_shader->getShaderProgram() );
+      glUniform1f( wave_shader->getLocation( Uniform::WaveFactor ), WaveObject->getWaveFactor() );
+      glUniform2iv( wave_shader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+   }
    glDispatchCompute( getGroupSize( WavePointNumSize.x ), getGroupSize( WavePointNumSize.y ), 1 );
    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
 
+   // the substep kernel left the second newest level in the spare buffer, which takes the place of the old
+   // current level. after the rotation below, that level is the previous one and the newest is the current one.
+   if (step_num > 1) WaveObject->swapWaveSpareBuffer( (WaveTargetIndex + 1) % 3 );
    WaveTargetIndex = (WaveTargetIndex + 1) % 3;
+   return false;
+}
 
-   glUseProgram( ObjectShader->getShaderProgram() );
-   ObjectShader->transferBasicTransformationUniforms( glm::mat4(1.0f), MainCamera.get() );
-   WaveObject->transferUniformsToShader( ObjectShader.get() );
-   Lights->transferUniformsToShader( ObjectShader.get() );
-   glUniform1i( ObjectShader->getLocation( "LightIndex" ), ActiveLightIndex );
-   glUniform1i( ObjectShader->getLocation( "UseTexture" ), 1 );
+void RendererGL::estimateWaveSurface()
+{
+   const CPUZone zone( "RendererGL::estimateWaveSurface" );
+   if (RenderMode != WaveRenderMode::VertexAttributes && RenderMode != WaveRenderMode::VertexPulling) return;
+
+   GPUTimer->begin( NormalPass );
+   // the blend changes every frame, so the surface is estimated again even when no step was due.
+   const bool vertex_pulling = RenderMode == WaveRenderMode::VertexPulling;
+   const GLuint surface_buffer = vertex_pulling ? WaveObject->getWaveSurfaceBuffer() : WaveObject->getVBO();
+   const GLbitfield surface_barrier = vertex_pulling ? GL_SHADER_STORAGE_BARRIER_BIT : GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+   const ShaderGL* normal_shader = vertex_pulling ? WavePullingNormalShader.get() : WaveNormalShader.get();
+   glUseProgram( normal_shader->getShaderProgram() );
+   glUniform2iv( normal_shader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+   glUniform2fv( normal_shader->getLocation( Uniform::WaveGridStep ), 1, &WaveObject->getWaveGridStep()[0] );
+   glUniform1f( normal_shader->getLocation( Uniform::WaveLevelBlend ), WaveLevelBlend );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, DrawnWaveLevels[1] );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, surface_buffer );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, DrawnWaveLevels[0] );
+   glDispatchCompute( getGroupSize( WavePointNumSize.x ), getGroupSize( WavePointNumSize.y ), 1 );
+   glMemoryBarrier( surface_barrier );
+   GPUTimer->end( NormalPass );
+}
+
+void RendererGL::updateWave()
+{
+   const CPUZone zone( "RendererGL::updateWave" );
+   // without interpolation the newest level is drawn as it is, a step ahead of the interpolated surface.
+   // a headless frame stands for exactly one step interval, so a batch job steps the same levels however slow it is.
+   const int step_num = HeadlessFrameNum > 0 ? WaveClock->advance( WaveStepInterval ) : WaveClock->advance();
+   WaveLevelBlend = LevelInterpolation ? WaveClock->getLevelBlend() : 1.0f;
+   // the queries belong to this context, so the steps of the simulation thread are not timed.
+   // a frame without a due step dispatches nothing, and leaves no step time.
+   if (step_num > 0) GPUTimer->begin( StepPass );
+   const bool surface_estimated = stepWave( step_num, StepKernel );
+   if (step_num > 0) GPUTimer->end( StepPass );
+
+   const bool height_images = WaveObject->getWaveImage( 0 ) != 0;
+   for (int i = 0; i < 2; ++i) {
+      const int index = (WaveTargetIndex + i) % 3;
+      DrawnWaveLevels[i] = height_images ? WaveObject->getWaveImage( index ) : WaveObject->getWaveBuffer( index );
+   }
+   if (!surface_estimated) estimateWaveSurface();
+}
+
+void RendererGL::simulateWave()
+{
+   CPUProfiler::setThreadName( "simulation" );
+   glfwMakeContextCurrent( SimulationWindow );
+
+   // the fused kernel writes the render surface, which belongs to the render thread here.
+   const WaveStepKernel step_kernel = StepKernel == WaveStepKernel::Fused ? WaveStepKernel::Global : StepKernel;
+   // WaveClock is shared with the render thread. that thread leaves it to this one while it runs,
+   // and only reads its constant step interval.
+   WaveClock->reset();
+   publishWaveLevels();
+   while (!SimulationStopped.load( std::memory_order_acquire )) {
+      const int step_num = WaveClock->advance();
+      if (step_num == 0) {
+         const double remaining_time = (1.0 - WaveClock->getLevelBlend()) * WaveClock->getStepInterval();
+         std::this_thread::sleep_for( std::chrono::duration<double>(remaining_time) );
+         continue;
+      }
+      static_cast<void>(stepWave( step_num, step_kernel ));
+      publishWaveLevels();
+   }
+
+   // the render thread goes on with the levels in place once this thread has joined.
+   glFinish();
+   glfwMakeContextCurrent( nullptr );
+}
+
+void RendererGL::publishWaveLevels()
+{
+   const CPUZone zone( "RendererGL::publishWaveLevels" );
+   // there are three slots, so one is always neither drawn nor about to be.
+   int slot = 0;
+   {
+      std::lock_guard<std::mutex> lock( PublishLock );
+      while (slot == LatestPublishSlot || slot == ReadingPublishSlot) slot++;
+      if (WavePublishSlots[slot].ReadFence != nullptr) {
+         glWaitSync( WavePublishSlots[slot].ReadFence, 0, GL_TIMEOUT_IGNORED );
+      }
+   }
+
+   // the copies read what the step dispatches wrote, which is not covered by their storage barriers.
+   glMemoryBarrier( GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT );
+   WaveObject->copyWaveLevel( WaveTargetIndex, slot * 2 );
+   WaveObject->copyWaveLevel( (WaveTargetIndex + 1) % 3, slot * 2 + 1 );
+   const GLsync written_fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+   glFlush();
+
+   std::lock_guard<std::mutex> lock( PublishLock );
+   WavePublishSlot& published = WavePublishSlots[slot];
+   if (published.WrittenFence != nullptr) glDeleteSync( published.WrittenFence );
+   published.WrittenFence = written_fence;
+   published.LevelBlend = WaveClock->getLevelBlend();
+   published.PublishTime = std::chrono::steady_clock::now();
+   LatestPublishSlot = slot;
+}
+
+bool RendererGL::acquireWaveLevels()
+{
+   const CPUZone zone( "RendererGL::acquireWaveLevels" );
+   GLsync written_fence;
+   {
+      std::lock_guard<std::mutex> lock( PublishLock );
+      if (LatestPublishSlot < 0) return false;
+
+      ReadingPublishSlot = LatestPublishSlot;
+      const WavePublishSlot& published = WavePublishSlots[ReadingPublishSlot];
+      written_fence = published.WrittenFence;
+      const double elapsed_time =
+         std::chrono::duration<double>(std::chrono::steady_clock::now() - published.PublishTime).count();
+      const auto level_blend = static_cast<float>(published.LevelBlend + elapsed_time / WaveClock->getStepInterval());
+      WaveLevelBlend = LevelInterpolation ? std::min( level_blend, 1.0f ) : 1.0f;
+      glWaitSync( written_fence, 0, GL_TIMEOUT_IGNORED );
+   }
+
+   DrawnWaveLevels[0] = WaveObject->getWaveLevelCopy( ReadingPublishSlot * 2 );
+   DrawnWaveLevels[1] = WaveObject->getWaveLevelCopy( ReadingPublishSlot * 2 + 1 );
+   estimateWaveSurface();
+   return true;
+}
+
+void RendererGL::releaseWaveLevels()
+{
+   const CPUZone zone( "RendererGL::releaseWaveLevels" );
+   const GLsync read_fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+   glFlush();
+
+   std::lock_guard<std::mutex> lock( PublishLock );
+   WavePublishSlot& published = WavePublishSlots[ReadingPublishSlot];
+   if (published.ReadFence != nullptr) glDeleteSync( published.ReadFence );
+   published.ReadFence = read_fence;
+}
+
+void RendererGL::startWaveThread()
+{
+   if (SimulationWindow == nullptr) {
+      // the simulation thread needs a context of its own which shares the buffers, textures and programs.
+      glfwWindowHint( GLFW_VISIBLE, GLFW_FALSE );
+      SimulationWindow = glfwCreateWindow( 1, 1, "Wave Simulation", nullptr, Window );
+      glfwWindowHint( GLFW_VISIBLE, GLFW_TRUE );
+      glfwMakeContextCurrent( Window );
+   }
+   WaveObject->prepareWaveLevelCopies( static_cast<int>(WavePublishSlots.size()) * 2 );
+   LatestPublishSlot = -1;
+   ReadingPublishSlot = -1;
+   glFinish();
+
+   SimulationStopped.store( false, std::memory_order_release );
+   SimulationThread = std::thread( &RendererGL::simulateWave, this );
+}
+
+void RendererGL::stopWaveThread()
+{
+   SimulationStopped.store( true, std::memory_order_release );
+   SimulationThread.join();
+   for (auto& slot : WavePublishSlots) {
+      if (slot.WrittenFence != nullptr) glDeleteSync( slot.WrittenFence );
+      if (slot.ReadFence != nullptr) glDeleteSync( slot.ReadFence );
+      slot.WrittenFence = nullptr;
+      slot.ReadFence = nullptr;
+   }
+}
+
+void RendererGL::readBackWaveHeights()
+{
+   const CPUZone zone( "RendererGL::readBackWaveHeights" );
+   // the newest drawn level is copied for a later frame, and whatever an earlier frame copied is read without waiting.
+   WaveObject->requestWaveReadback( DrawnWaveLevels[1] );
+   int request_age = 0;
+   const GLfloat* heights = WaveObject->getWaveReadback( request_age );
+   if (heights == nullptr) {
+      ReadbackMissNum++;
+      return;
+   }
+
+   ReadbackCenterHeight = heights[(WavePointNumSize.y / 2) * WavePointNumSize.x + WavePointNumSize.x / 2];
+   ReadbackAgeSum += request_age;
+   ReadbackFrameNum++;
+}
+
+void RendererGL::cullWaveChunks()
+{
+   const bool height_image = RenderMode == WaveRenderMode::HeightImage;
+   const ShaderGL* cull_shader = height_image ? WaveImageCullShader.get() : WaveCullShader.get();
+   const glm::mat4 view_projection = MainCamera->getProjectionMatrix() * MainCamera->getViewMatrix();
+   glUseProgram( cull_shader->getShaderProgram() );
+   glUniformMatrix4fv( cull_shader->getLocation( Uniform::ModelViewProjectionMatrix ), 1, GL_FALSE, &view_projection[0][0] );
+   glUniform2iv( cull_shader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+   glUniform2fv( cull_shader->getLocation( Uniform::WaveGridStep ), 1, &WaveObject->getWaveGridStep()[0] );
+   glUniform1f( cull_shader->getLocation( Uniform::WaveLevelBlend ), WaveLevelBlend );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, WaveObject->getWaveChunkBuffer() );
+   glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 1, WaveObject->getWaveChunkCommandBuffer() );
+   if (height_image) {
+      glBindTextureUnit( 1, DrawnWaveLevels[1] );
+      glBindTextureUnit( 2, DrawnWaveLevels[0] );
+   }
+   else {
+      glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 2, DrawnWaveLevels[1] );
+      glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 3, DrawnWaveLevels[0] );
+   }
+   glDispatchCompute( WaveObject->getWaveChunkNum(), 1, 1 );
+   glMemoryBarrier( GL_COMMAND_BARRIER_BIT );
+}
+
+void RendererGL::drawWaveClipmap(const ShaderGL* shader) const
+{
+   constexpr int n = ObjectGL::WaveClipmapSize;
+   const int level_num = WaveObject->getWaveClipmapLevelNum();
+   const glm::vec3 camera_position = MainCamera->getCameraPosition();
+   const glm::vec2 camera_point =
+      glm::floor( glm::vec2(camera_position.x, camera_position.z) / WaveObject->getWaveGridStep() );
+   glUniform1i( shader->getLocation( Uniform::ClipmapSize ), n );
+
+   // every level is centred on the camera and snapped to twice its vertex spacing,
+   // so that the finer level starts on a vertex of it a quarter or a quarter plus one cell in.
+   glm::ivec2 finer_origin(0);
+   for (int level = 0; level < level_num; ++level) {
+      const auto snap = static_cast<float>(2 << level);
+      const glm::ivec2 origin = glm::ivec2(glm::floor( camera_point / snap ) * snap) - ((n / 2) << level);
+      int mesh = 0;
+      if (level > 0) {
+         const glm::ivec2 hole_offset = (finer_origin - origin) / (1 << level) - n / 4;
+         mesh = 1 + hole_offset.x + 2 * hole_offset.y;
+      }
+      finer_origin = origin;
+
+      // the finer levels of a level outside the domain are outside as well.
+      const glm::ivec2 origin_end = origin + (n << level);
+      if (origin_end.x < 0 || origin_end.y < 0 || origin.x >= WavePointNumSize.x || origin.y >= WavePointNumSize.y) {
+         continue;
+      }
+
+      glUniform1i( shader->getLocation( Uniform::ClipmapLevel ), level );
+      glUniform2iv( shader->getLocation( Uniform::ClipmapOrigin ), 1, &origin[0] );
+      glDrawElements(
+         WaveObject->getDrawMode(),
+         WaveObject->getWaveClipmapIndexNum( mesh ),
+         GL_UNSIGNED_INT,
+         reinterpret_cast<GLvoid *>(WaveObject->getWaveClipmapIndexOffset( mesh ) * sizeof( GLuint ))
+      );
+   }
+}
+
+void RendererGL::drawWaveObject()
+{
+   const CPUZone zone( "RendererGL::drawWaveObject" );
+   const bool chunk_culling = ChunkCulling &&
+      RenderMode != WaveRenderMode::TessellatedImage && RenderMode != WaveRenderMode::ClipmapImage;
+   if (chunk_culling) {
+      GPUTimer->begin( CullPass );
+      cullWaveChunks();
+      GPUTimer->end( CullPass );
+   }
+
+   // the draw pass ends in render(), after whichever of the draws below this frame takes.
+   GPUTimer->begin( DrawPass );
+   ShaderGL* scene_shader;
+   switch (RenderMode) {
+      case WaveRenderMode::VertexPulling: scene_shader = WavePullingShader.get(); break;
+      case WaveRenderMode::HeightImage: scene_shader = WaveDisplacementShader.get(); break;
+      case WaveRenderMode::TessellatedImage: scene_shader = WaveTessellationShader.get(); break;
+      case WaveRenderMode::ClipmapImage: scene_shader = WaveClipmapShader.get(); break;
+      default: scene_shader = ObjectShader.get(); break;
+   }
+   glUseProgram( scene_shader->getShaderProgram() );
+   MainCamera->transferCameraBuffer( glm::mat4(1.0f) );
+   WaveObject->transferMaterialBuffer();
+   Lights->transferLightBuffer( MainCamera->getViewMatrix() );
+   glUniform1i( scene_shader->getLocation( Uniform::LightIndex ), ActiveLightIndex );
+   glUniform1i( scene_shader->getLocation( Uniform::UseTexture ), 1 );
+   if (RenderMode != WaveRenderMode::VertexAttributes) {
+      glUniform2iv( scene_shader->getLocation( Uniform::WavePointNumSize ), 1, &WavePointNumSize[0] );
+      glUniform2fv( scene_shader->getLocation( Uniform::WaveGridStep ), 1, &WaveObject->getWaveGridStep()[0] );
+      glUniform1f( scene_shader->getLocation( Uniform::WaveLevelBlend ), WaveLevelBlend );
+   }
+   switch (RenderMode) {
+      case WaveRenderMode::VertexPulling:
+         glBindBufferBase( GL_SHADER_STORAGE_BUFFER, 0, WaveObject->getWaveSurfaceBuffer() );
+         break;
+      case WaveRenderMode::HeightImage:
+      case WaveRenderMode::ClipmapImage:
+         glBindTextureUnit( 1, DrawnWaveLevels[1] );
+         glBindTextureUnit( 2, DrawnWaveLevels[0] );
+         break;
+      case WaveRenderMode::TessellatedImage: {
+         const glm::vec2 viewport_size(static_cast<float>(FrameWidth), static_cast<float>(FrameHeight));
+         glUniform1i( scene_shader->getLocation( Uniform::PatchSize ), ObjectGL::WavePatchSize );
+         glUniform2fv( scene_shader->getLocation( Uniform::ViewportSize ), 1, &viewport_size[0] );
+         glUniform1f( scene_shader->getLocation( Uniform::TargetEdgeLength ), TessellationEdgeLength );
+         glBindTextureUnit( 1, DrawnWaveLevels[1] );
+         glBindTextureUnit( 2, DrawnWaveLevels[0] );
+      } break;
+      default: break;
+   }
    glBindTextureUnit( 0, WaveObject->getTextureID( 0 ) );
    glBindVertexArray( WaveObject->getVAO() );
-   for (int j = 0; j < WavePointNumSize.y - 1; ++j) {
-      glDrawElements( 
-         WaveObject->getDrawMode(), 
-         WavePointNumSize.x * 2, 
-         GL_UNSIGNED_INT, 
-         reinterpret_cast<GLvoid *>(j * WavePointNumSize.x * 2 * sizeof( GLuint ))
+   if (RenderMode == WaveRenderMode::TessellatedImage) {
+      glPatchParameteri( GL_PATCH_VERTICES, 4 );
+      glDrawElements( WaveObject->getDrawMode(), WaveObject->getIndexNum(), GL_UNSIGNED_INT, nullptr );
+      return;
+   }
+   if (RenderMode == WaveRenderMode::ClipmapImage) {
+      drawWaveClipmap( scene_shader );
+      return;
+   }
+
+   // culled chunks have no instance in their indirect command. without culling, the rows are separated by restart
+   // indices, so the per-row draw is only kept to compare the submission cost.
+   const auto submit_start = std::chrono::steady_clock::now();
+   if (chunk_culling) {
+      glVertexArrayElementBuffer( WaveObject->getVAO(), WaveObject->getWaveChunkIndexBuffer() );
+      glBindBuffer( GL_DRAW_INDIRECT_BUFFER, WaveObject->getWaveChunkCommandBuffer() );
+      glMultiDrawElementsIndirect(
+         WaveObject->getDrawMode(), GL_UNSIGNED_INT, nullptr, WaveObject->getWaveChunkNum(), 0
       );
+      glVertexArrayElementBuffer( WaveObject->getVAO(), WaveObject->getIBO() );
+   }
+   else if (SingleCallDraw) {
+      glDrawElements( WaveObject->getDrawMode(), WaveObject->getIndexNum(), GL_UNSIGNED_INT, nullptr );
+   }
+   else {
+      const int row_index_num = WavePointNumSize.x * 2;
+      for (int j = 0; j < WavePointNumSize.y - 1; ++j) {
+         glDrawElements( 
+            WaveObject->getDrawMode(), 
+            row_index_num, 
+            GL_UNSIGNED_INT, 
+            reinterpret_cast<GLvoid *>(j * (row_index_num + 1) * sizeof( GLuint ))
+         );
+      }
    }
+   DrawSubmitTime += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - submit_start).count();
+   DrawSubmitFrameNum++;
+}
+
+void RendererGL::showGPUTimes()
+{
+   // the title is only rewritten twice a second, so that the numbers can be read.
+   const auto now = std::chrono::steady_clock::now();
+   if (now - TimingTitleTime < std::chrono::milliseconds(500)) return;
+
+   TimingTitleTime = now;
+   const std::string title = "Main Camera - GPU " + GPUTimer->getAverageTimeString();
+   glfwSetWindowTitle( Window, title.c_str() );
 }
 
 void RendererGL::render()
 {
+   CPUProfiler::beginFrame();
+   const CPUZone zone( "RendererGL::render" );
+   GPUTimer->beginFrame();
    glClear( OPENGL_COLOR_BUFFER_BIT | OPENGL_DEPTH_BUFFER_BIT );
 
-   drawWaveObject();
+   if (ThreadedSimulation) {
+      if (acquireWaveLevels()) {
+         drawWaveObject();
+         GPUTimer->end( DrawPass );
+         if (HeightReadback) readBackWaveHeights();
+         releaseWaveLevels();
+      }
+   }
+   else {
+      updateWave();
+      drawWaveObject();
+      GPUTimer->end( DrawPass );
+      if (HeightReadback) readBackWaveHeights();
+   }
 
    glBindVertexArray( 0 );
    glUseProgram( 0 );
+   if (GPUTimer->isEnabled() && Window != nullptr) showGPUTimes();
+}
+
+bool RendererGL::captureFrame(const std::string& file_path) const
+{
+   // FreeImage keeps the rows bottom-up and in BGRA order on little-endian machines, just as glReadPixels gives them.
+   const int width = Headless->getWidth();
+   const int height = Headless->getHeight();
+   std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+   glNamedFramebufferReadBuffer( Headless->getFBO(), GL_COLOR_ATTACHMENT0 );
+   glReadPixels( 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, pixels.data() );
+
+   FIBITMAP* frame = FreeImage_ConvertFromRawBits(
+      pixels.data(), width, height, width * 4, 32,
+      FI_RGBA_RED_MASK, FI_RGBA_GREEN_MASK, FI_RGBA_BLUE_MASK, FALSE
+   );
+   if (frame == nullptr) return false;
+
+   const bool saved = FreeImage_Save( FIF_PNG, frame, file_path.c_str() ) != FALSE;
+   FreeImage_Unload( frame );
+   return saved;
+}
+
+void RendererGL::playHeadless()
+{
+   for (int frame = 1; frame <= HeadlessFrameNum; ++frame) {
+      render();
+      if (CaptureInterval > 0 && frame % CaptureInterval == 0) {
+         std::ostringstream file_name;
+         file_name << "wave_frame_" << std::setw( 5 ) << std::setfill( '0' ) << frame << ".png";
+         if (!captureFrame( file_name.str() )) std::cout << "Cannot Save " << file_name.str() << "\n";
+      }
+   }
+   glFinish();
+   GPUTimer->flush();
+   std::cout << "Headless Frames Rendered: " << HeadlessFrameNum << "\n";
+   if (GPUTimer->isEnabled()) std::cout << "GPU Pass Times: " << GPUTimer->getAverageTimeString() << "\n";
+}
+
+void RendererGL::setGPUTimingLog(const std::string& file_path)
+{
+   if (!GPUTimer->setCSVFile( file_path )) {
+      std::cout << "Cannot Open " << file_path << "\n";
+      return;
+   }
+   GPUTimer->setEnabled( true );
 }
 
 void RendererGL::play()
 {
-   if (glfwWindowShouldClose( Window )) initialize();
+   if (!Initialized) return;
+   if (HeadlessFrameNum == 0 && glfwWindowShouldClose( Window )) {
+      Initialized = initialize();
+      if (!Initialized) return;
+   }
 
    setLights();
-   WaveObject->setWaveObject( WavePointNumSize, WaveGridSize );
+   setWaveObject();
    WaveShader->setWaveUniformLocations();
+   WaveTiledShader->setWaveUniformLocations();
+   WaveFusedShader->setWaveFusedUniformLocations();
+   WaveBlockedShader->setWaveBlockedUniformLocations();
    WaveNormalShader->setWaveNormalUniformLocations();
-   ObjectShader->setSceneUniformLocations( Lights->getTotalLightNum() );
+   WavePullingNormalShader->setWaveNormalUniformLocations();
+   WavePullingFusedShader->setWaveFusedUniformLocations();
+   ObjectShader->setSceneUniformLocations();
+   WavePullingShader->setWaveSceneUniformLocations();
+   WaveImageShader->setWaveUniformLocations();
+   WaveCullShader->setWaveCullUniformLocations();
+   WaveImageCullShader->setWaveCullUniformLocations();
+   WaveDisplacementShader->setWaveSceneUniformLocations();
+   WaveTessellationShader->setWaveTessellationUniformLocations();
+   WaveClipmapShader->setWaveClipmapUniformLocations();
+
+   if (HeadlessFrameNum > 0) {
+      playHeadless();
+      return;
+   }
 
    while (!glfwWindowShouldClose( Window )) {
       render();
       
-      glfwPollEvents();
-      glfwSwapBuffers( Window );
+      {
+         const CPUZone zone( "glfwPollEvents" );
+         glfwPollEvents();
+      }
+      {
+         const CPUZone zone( "glfwSwapBuffers" );
+         glfwSwapBuffers( Window );
+      }
    }
+   if (ThreadedSimulation) stopWaveThread();
+   // the queries of the last frames are read while their context still exists.
+   GPUTimer->flush();
+   if (SimulationWindow != nullptr) glfwDestroyWindow( SimulationWindow );
    glfwDestroyWindow( Window );
 }
\ No newline at end of file
@@ -1,7 +1,8 @@
 #include "shader.h"
 
-ShaderGL::ShaderGL() : ShaderProgram( 0 )
+ShaderGL::ShaderGL() : ShaderProgram( 0 ), UniformLocations{}
 {
+   UniformLocations.fill( -1 );
 }
 
 ShaderGL::~ShaderGL()
@@ -25,6 +26,20 @@ void ShaderGL::readShaderFile(std::string& shader_contents, const char* shader_p
    file.close();
 }
 
+void ShaderGL::insertDefines(std::string& shader_contents, const std::vector<std::string>& defines)
+{
+   if (defines.empty()) return;
+
+   // the defines have to follow the #version directive, and #line keeps the compile errors on the file's line numbers.
+   std::string define_lines;
+   for (const auto& define : defines) define_lines.append( "#define " + define + "\n" );
+   define_lines.append( "#line 2\n" );
+
+   const size_t version_end = shader_contents.find( '\n' );
+   if (version_end == std::string::npos) return;
+   shader_contents.insert( version_end + 1, define_lines );
+}
+
 std::string ShaderGL::getShaderTypeString(GLenum shader_type)
 {
    switch (shader_type) {
@@ -57,13 +72,8 @@ bool ShaderGL::checkCompileError(GLenum shader_type, const GLuint& shader)
    return compiled == GL_TRUE;
 }
 
-GLuint ShaderGL::getCompiledShader(GLenum shader_type, const char* shader_path)
+GLuint ShaderGL::getCompiledShader(GLenum shader_type, const std::string& shader_contents)
 {
-   if (shader_path == nullptr) return 0;
-
-   std::string shader_contents;
-   readShaderFile( shader_contents, shader_path );
-
    const GLuint shader = glCreateShader( shader_type );
    const char* shader_source = shader_contents.c_str();
    glShaderSource( shader, 1, &shader_source, nullptr );
@@ -75,6 +85,124 @@ GLuint ShaderGL::getCompiledShader(GLenum shader_type, const char* shader_path)
    return shader;
 }
 
+void ShaderGL::addShaderSource(
+   ShaderSources& sources,
+   GLenum shader_type,
+   const char* shader_path,
+   const std::vector<std::string>& defines
+)
+{
+   if (shader_path == nullptr) return;
+
+   std::string shader_contents;
+   readShaderFile( shader_contents, shader_path );
+   insertDefines( shader_contents, defines );
+   sources.emplace_back( shader_type, std::move( shader_contents ) );
+}
+
+void ShaderGL::setProgramCacheDirectory(const std::string& directory_path)
+{
+   std::error_code error;
+   std::filesystem::create_directories( directory_path, error );
+   if (error) {
+      std::cerr << "Cannot create the program cache directory: " << directory_path << "\n";
+      ProgramCacheDirectory.clear();
+      return;
+   }
+   ProgramCacheDirectory = directory_path;
+}
+
+std::string ShaderGL::getProgramCachePath(const ShaderSources& sources)
+{
+   if (ProgramCacheDirectory.empty()) return "";
+
+   GLint binary_format_num = 0;
+   glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_num );
+   if (binary_format_num == 0) return "";
+
+   // a binary only fits the driver which made it, so the driver strings are hashed along with the sources.
+   // 64-bit FNV-1a, with the length of each string mixed in so that no two lists of strings run together.
+   uint64_t hash = 14695981039346656037ull;
+   const auto mix = [&hash](const std::string& text) {
+      for (const char c : text + std::to_string( text.size() )) {
+         hash ^= static_cast<uchar>(c);
+         hash *= 1099511628211ull;
+      }
+   };
+   for (const GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+      mix( reinterpret_cast<const char*>(glGetString( name )) );
+   }
+   for (const auto& source : sources) {
+      mix( std::to_string( source.first ) );
+      mix( source.second );
+   }
+
+   std::ostringstream cache_path;
+   cache_path << ProgramCacheDirectory << "/" << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash << ".bin";
+   return cache_path.str();
+}
+
+bool ShaderGL::loadProgramBinary(const std::string& cache_path)
+{
+   std::ifstream file( cache_path, std::ios::in | std::ios::binary );
+   if (!file.is_open()) return false;
+
+   GLenum binary_format = 0;
+   file.read( reinterpret_cast<char*>(&binary_format), sizeof( binary_format ) );
+   const std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+   if (!file.good() && !file.eof()) return false;
+   if (binary.empty()) return false;
+
+   // a driver update may reject the binary, and the program is then linked from the sources as usual.
+   glProgramBinary( ShaderProgram, binary_format, binary.data(), static_cast<GLsizei>(binary.size()) );
+   GLint linked = GL_FALSE;
+   glGetProgramiv( ShaderProgram, GL_LINK_STATUS, &linked );
+   if (linked == GL_FALSE) {
+      glDeleteProgram( ShaderProgram );
+      ShaderProgram = glCreateProgram();
+      return false;
+   }
+   return true;
+}
+
+void ShaderGL::saveProgramBinary(const std::string& cache_path) const
+{
+   GLint linked = GL_FALSE;
+   GLint binary_length = 0;
+   glGetProgramiv( ShaderProgram, GL_LINK_STATUS, &linked );
+   glGetProgramiv( ShaderProgram, GL_PROGRAM_BINARY_LENGTH, &binary_length );
+   if (linked == GL_FALSE || binary_length == 0) return;
+
+   GLenum binary_format = 0;
+   std::vector<char> binary(binary_length);
+   glGetProgramBinary( ShaderProgram, binary_length, &binary_length, &binary_format, binary.data() );
+
+   std::ofstream file( cache_path, std::ios::out | std::ios::binary | std::ios::trunc );
+   if (!file.is_open()) return;
+   file.write( reinterpret_cast<const char*>(&binary_format), sizeof( binary_format ) );
+   file.write( binary.data(), binary_length );
+}
+
+void ShaderGL::linkProgram(const ShaderSources& sources)
+{
+   ShaderProgram = glCreateProgram();
+   const std::string cache_path = getProgramCachePath( sources );
+   if (!cache_path.empty() && loadProgramBinary( cache_path )) return;
+
+   std::vector<GLuint> shaders;
+   for (const auto& source : sources) {
+      const GLuint shader = getCompiledShader( source.first, source.second );
+      if (shader == 0) continue;
+
+      glAttachShader( ShaderProgram, shader );
+      shaders.emplace_back( shader );
+   }
+   if (!cache_path.empty()) glProgramParameteri( ShaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+   glLinkProgram( ShaderProgram );
+   for (const auto& shader : shaders) glDeleteShader( shader );
+   if (!cache_path.empty()) saveProgramBinary( cache_path );
+}
+
 void ShaderGL::setShader(
    const char* vertex_shader_path,
    const char* fragment_shader_path,
@@ -83,97 +211,85 @@ void ShaderGL::setShader(
    const char* tessellation_evaluation_shader_path
 )
 {
-   const GLuint vertex_shader = getCompiledShader( GL_VERTEX_SHADER, vertex_shader_path );
-   const GLuint fragment_shader = getCompiledShader( GL_FRAGMENT_SHADER, fragment_shader_path );
-   const GLuint geometry_shader = getCompiledShader( GL_GEOMETRY_SHADER, geometry_shader_path );
-   const GLuint tessellation_control_shader = getCompiledShader( GL_TESS_CONTROL_SHADER, tessellation_control_shader_path );
-   const GLuint tessellation_evaluation_shader = getCompiledShader( GL_TESS_EVALUATION_SHADER, tessellation_evaluation_shader_path );
-   ShaderProgram = glCreateProgram();
-   glAttachShader( ShaderProgram, vertex_shader );
-   glAttachShader( ShaderProgram, fragment_shader );
-   if (geometry_shader != 0) glAttachShader( ShaderProgram, geometry_shader );
-   if (tessellation_control_shader != 0) glAttachShader( ShaderProgram, tessellation_control_shader );
-   if (tessellation_evaluation_shader != 0) glAttachShader( ShaderProgram, tessellation_evaluation_shader );
-   glLinkProgram( ShaderProgram );
-   glDeleteShader( vertex_shader );
-   glDeleteShader( fragment_shader );
-   if (geometry_shader != 0) glDeleteShader( geometry_shader );
-   if (tessellation_control_shader != 0) glDeleteShader( tessellation_control_shader );
-   if (tessellation_evaluation_shader != 0) glDeleteShader( tessellation_evaluation_shader );
-}
-
-void ShaderGL::setComputeShaders(const char* compute_shader_path)
-{
-   const GLuint compute_shader = getCompiledShader( GL_COMPUTE_SHADER, compute_shader_path );
-   ShaderProgram = glCreateProgram();
-   glAttachShader( ShaderProgram, compute_shader );
-   glLinkProgram( ShaderProgram );
-   glDeleteShader( compute_shader );
+   const CPUZone zone( "ShaderGL::setShader" );
+   ShaderSources sources;
+   addShaderSource( sources, GL_VERTEX_SHADER, vertex_shader_path );
+   addShaderSource( sources, GL_FRAGMENT_SHADER, fragment_shader_path );
+   addShaderSource( sources, GL_GEOMETRY_SHADER, geometry_shader_path );
+   addShaderSource( sources, GL_TESS_CONTROL_SHADER, tessellation_control_shader_path );
+   addShaderSource( sources, GL_TESS_EVALUATION_SHADER, tessellation_evaluation_shader_path );
+   linkProgram( sources );
 }
 
-void ShaderGL::setBasicTransformationUniforms()
+void ShaderGL::setComputeShaders(const char* compute_shader_path, const std::vector<std::string>& defines)
 {
-   Location.World = glGetUniformLocation( ShaderProgram, "WorldMatrix" );
-   Location.View = glGetUniformLocation( ShaderProgram, "ViewMatrix" );
-   Location.Projection = glGetUniformLocation( ShaderProgram, "ProjectionMatrix" );
-   Location.ModelViewProjection = glGetUniformLocation( ShaderProgram, "ModelViewProjectionMatrix" );
+   const CPUZone zone( "ShaderGL::setComputeShaders" );
+   ShaderSources sources;
+   addShaderSource( sources, GL_COMPUTE_SHADER, compute_shader_path, defines );
+   linkProgram( sources );
 }
 
 void ShaderGL::setWaveUniformLocations()
 {
-   addUniformLocation( "WaveFactor" );
-   addUniformLocation( "WavePointNumSize" );
+   addUniformLocation( Uniform::WaveFactor );
+   addUniformLocation( Uniform::WavePointNumSize );
 }
 
 void ShaderGL::setWaveNormalUniformLocations()
 {
-   addUniformLocation( "WavePointNumSize" );
+   addUniformLocation( Uniform::WavePointNumSize );
+   addUniformLocation( Uniform::WaveGridStep );
+   addUniformLocation( Uniform::WaveLevelBlend );
 }
 
-void ShaderGL::setSceneUniformLocations(int light_num)
+void ShaderGL::setWaveFusedUniformLocations()
 {
-   setBasicTransformationUniforms();
-
-   Location.MaterialEmission = glGetUniformLocation( ShaderProgram, "Material.EmissionColor" );
-   Location.MaterialAmbient = glGetUniformLocation( ShaderProgram, "Material.AmbientColor" );
-   Location.MaterialDiffuse = glGetUniformLocation( ShaderProgram, "Material.DiffuseColor" );
-   Location.MaterialSpecular = glGetUniformLocation( ShaderProgram, "Material.SpecularColor" );
-   Location.MaterialSpecularExponent = glGetUniformLocation( ShaderProgram, "Material.SpecularExponent" );
+   setWaveUniformLocations();
+   addUniformLocation( Uniform::WaveGridStep );
+   addUniformLocation( Uniform::WaveLevelBlend );
+}
 
-   Location.Texture[0] = glGetUniformLocation( ShaderProgram, "BaseTexture" );
+void ShaderGL::setWaveBlockedUniformLocations()
+{
+   setWaveUniformLocations();
+   addUniformLocation( Uniform::SubstepNum );
+}
 
-   Location.UseLight = glGetUniformLocation( ShaderProgram, "UseLight" );
-   Location.LightNum = glGetUniformLocation( ShaderProgram, "LightNum" );
-   Location.GlobalAmbient = glGetUniformLocation( ShaderProgram, "GlobalAmbient" );
+void ShaderGL::setWaveCullUniformLocations()
+{
+   addUniformLocation( Uniform::ModelViewProjectionMatrix );
+   addUniformLocation( Uniform::WavePointNumSize );
+   addUniformLocation( Uniform::WaveGridStep );
+   addUniformLocation( Uniform::WaveLevelBlend );
+}
 
-   Location.Lights.resize( light_num );
-   for (int i = 0; i < light_num; ++i) {
-      Location.Lights[i].LightSwitch = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].LightSwitch").c_str() );
-      Location.Lights[i].LightPosition = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].Position").c_str() );
-      Location.Lights[i].LightAmbient = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].AmbientColor").c_str() );
-      Location.Lights[i].LightDiffuse = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].DiffuseColor").c_str() );
-      Location.Lights[i].LightSpecular = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpecularColor").c_str() );
-      Location.Lights[i].SpotlightDirection = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightDirection").c_str() );
-      Location.Lights[i].SpotlightCutoffAngle = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightCutoffAngle").c_str() );
-      Location.Lights[i].SpotlightFeather = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].SpotlightFeather").c_str() );
-      Location.Lights[i].LightFallOffRadius = glGetUniformLocation( ShaderProgram, std::string("Lights[" + std::to_string( i ) + "].FallOffRadius").c_str() );
-   }
+void ShaderGL::setSceneUniformLocations()
+{
+   // the camera, the material and the lights come from uniform blocks, and BaseTexture is bound to unit 0 in the shader.
+   addUniformLocation( Uniform::UseTexture );
+   addUniformLocation( Uniform::LightIndex );
+}
 
-   addUniformLocation( "UseTexture" );
-   addUniformLocation( "LightIndex" );
+void ShaderGL::setWaveSceneUniformLocations()
+{
+   setSceneUniformLocations();
+   addUniformLocation( Uniform::WavePointNumSize );
+   addUniformLocation( Uniform::WaveGridStep );
+   addUniformLocation( Uniform::WaveLevelBlend );
 }
 
-void ShaderGL::transferBasicTransformationUniforms(const glm::mat4& to_world, const CameraGL* camera) const
+void ShaderGL::setWaveTessellationUniformLocations()
 {
-   const glm::mat4 view = camera->getViewMatrix();
-   const glm::mat4 projection = camera->getProjectionMatrix();
-   const glm::mat4 model_view_projection = projection * view * to_world;
-   glUniformMatrix4fv( Location.World, 1, GL_FALSE, &to_world[0][0] );
-   glUniformMatrix4fv( Location.View, 1, GL_FALSE, &view[0][0] );
-   glUniformMatrix4fv( Location.Projection, 1, GL_FALSE, &projection[0][0] );
-   glUniformMatrix4fv( Location.ModelViewProjection, 1, GL_FALSE, &model_view_projection[0][0] );
+   setWaveSceneUniformLocations();
+   addUniformLocation( Uniform::PatchSize );
+   addUniformLocation( Uniform::ViewportSize );
+   addUniformLocation( Uniform::TargetEdgeLength );
+}
 
-   for (const auto& texture : Location.Texture) {
-      glUniform1i( texture.second, texture.first );
-   }
+void ShaderGL::setWaveClipmapUniformLocations()
+{
+   setWaveSceneUniformLocations();
+   addUniformLocation( Uniform::ClipmapSize );
+   addUniformLocation( Uniform::ClipmapLevel );
+   addUniformLocation( Uniform::ClipmapOrigin );
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "simulation_clock.h"
+
+#include <cmath>
+
+SimulationClock::SimulationClock(double step_interval, int max_step_num) :
+   StepInterval( step_interval ), MaxStepNum( max_step_num ), Accumulator( 0.0 ), DroppedTime( 0.0 ),
+   LastTime( std::chrono::steady_clock::now() )
+{
+}
+
+void SimulationClock::reset()
+{
+   Accumulator = 0.0;
+   DroppedTime = 0.0;
+   LastTime = std::chrono::steady_clock::now();
+}
+
+int SimulationClock::advance()
+{
+   const auto now = std::chrono::steady_clock::now();
+   const double elapsed_time = std::chrono::duration<double>(now - LastTime).count();
+   LastTime = now;
+   return advance( elapsed_time );
+}
+
+int SimulationClock::advance(double elapsed_time)
+{
+   Accumulator += elapsed_time;
+   auto step_num = static_cast<int>(std::floor( Accumulator / StepInterval ));
+   if (step_num > MaxStepNum) {
+      // keeps the phase within a step, so the interpolation does not jump.
+      const double remainder = std::fmod( Accumulator, StepInterval );
+      DroppedTime += Accumulator - remainder - static_cast<double>(MaxStepNum) * StepInterval;
+      Accumulator = remainder + static_cast<double>(MaxStepNum) * StepInterval;
+      step_num = MaxStepNum;
+   }
+   Accumulator -= static_cast<double>(step_num) * StepInterval;
+   return step_num;
+}
\ No newline at end of file
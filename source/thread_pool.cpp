@@ -0,0 +1,141 @@
+#include "thread_pool.h"
+
+#include <cstring>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+ThreadPool::ThreadPool(int thread_num, bool pin_threads) :
+   ThreadNum( thread_num > 0 ? thread_num : getHardwareThreadNum() ), PinThreads( pin_threads ), Terminate( false ),
+   Generation( 0 ), PublishedGeneration( 0 ), RemainingWorkers( 0 ), Task( nullptr ), CallerAffinity{}
+{
+   Workers.reserve( ThreadNum - 1 );
+   for (int i = 1; i < ThreadNum; ++i) Workers.emplace_back( &ThreadPool::work, this, i );
+
+   // the calling thread runs slice 0, so it is pinned like a worker.
+   if (PinThreads && ThreadNum > 1) {
+      saveCallerAffinity();
+      pinCurrentThread( 0 );
+   }
+}
+
+ThreadPool::~ThreadPool()
+{
+   {
+      std::lock_guard<std::mutex> lock( Lock );
+      Terminate = true;
+      PublishedGeneration.store( ++Generation, std::memory_order_release );
+   }
+   TaskReady.notify_all();
+   for (auto& worker : Workers) worker.join();
+   if (PinThreads && ThreadNum > 1) restoreCallerAffinity();
+}
+
+int ThreadPool::getHardwareThreadNum()
+{
+   const auto hardware_thread_num = static_cast<int>(std::thread::hardware_concurrency());
+   return hardware_thread_num > 0 ? hardware_thread_num : 1;
+}
+
+void ThreadPool::pinCurrentThread(int core_index)
+{
+   const int core = core_index % getHardwareThreadNum();
+#if defined(_WIN32)
+   SetThreadAffinityMask( GetCurrentThread(), static_cast<DWORD_PTR>(1) << core );
+#elif defined(__linux__)
+   cpu_set_t cpu_set;
+   CPU_ZERO( &cpu_set );
+   CPU_SET( core, &cpu_set );
+   pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpu_set );
+#else
+   static_cast<void>(core);
+#endif
+}
+
+void ThreadPool::saveCallerAffinity()
+{
+#if defined(_WIN32)
+   // SetThreadAffinityMask returns the previous mask, so the current one is read by setting it to core 0.
+   const DWORD_PTR mask = SetThreadAffinityMask( GetCurrentThread(), 1 );
+   CallerAffinity[0] = static_cast<uint64_t>(mask);
+#elif defined(__linux__)
+   static_assert( sizeof( cpu_set_t ) <= sizeof( CallerAffinity ) );
+   cpu_set_t cpu_set;
+   pthread_getaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpu_set );
+   std::memcpy( CallerAffinity.data(), &cpu_set, sizeof( cpu_set_t ) );
+#endif
+}
+
+void ThreadPool::restoreCallerAffinity() const
+{
+#if defined(_WIN32)
+   if (CallerAffinity[0] != 0) SetThreadAffinityMask( GetCurrentThread(), static_cast<DWORD_PTR>(CallerAffinity[0]) );
+#elif defined(__linux__)
+   cpu_set_t cpu_set;
+   std::memcpy( &cpu_set, CallerAffinity.data(), sizeof( cpu_set_t ) );
+   pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &cpu_set );
+#endif
+}
+
+void ThreadPool::work(int thread_index)
+{
+   if (PinThreads) pinCurrentThread( thread_index );
+
+   uint64_t seen_generation = 0;
+   while (true) {
+      for (int i = 0; i < SpinCount; ++i) {
+         if (PublishedGeneration.load( std::memory_order_acquire ) != seen_generation) break;
+         std::this_thread::yield();
+      }
+      if (PublishedGeneration.load( std::memory_order_acquire ) == seen_generation) {
+         std::unique_lock<std::mutex> lock( Lock );
+         TaskReady.wait(
+            lock, [this, seen_generation]() {
+               return PublishedGeneration.load( std::memory_order_acquire ) != seen_generation;
+            }
+         );
+      }
+      seen_generation = PublishedGeneration.load( std::memory_order_acquire );
+      if (Terminate) return;
+
+      (*Task)( thread_index );
+      if (RemainingWorkers.fetch_sub( 1, std::memory_order_acq_rel ) == 1) {
+         std::lock_guard<std::mutex> lock( Lock );
+         TaskDone.notify_one();
+      }
+   }
+}
+
+void ThreadPool::run(const std::function<void(int)>& task)
+{
+   if (ThreadNum == 1) {
+      task( 0 );
+      return;
+   }
+
+   Task = &task;
+   RemainingWorkers.store( ThreadNum - 1, std::memory_order_release );
+   {
+      std::lock_guard<std::mutex> lock( Lock );
+      PublishedGeneration.store( ++Generation, std::memory_order_release );
+   }
+   TaskReady.notify_all();
+
+   task( 0 );
+
+   for (int i = 0; i < SpinCount; ++i) {
+      if (RemainingWorkers.load( std::memory_order_acquire ) == 0) break;
+      std::this_thread::yield();
+   }
+   if (RemainingWorkers.load( std::memory_order_acquire ) != 0) {
+      std::unique_lock<std::mutex> lock( Lock );
+      TaskDone.wait( lock, [this]() { return RemainingWorkers.load( std::memory_order_acquire ) == 0; } );
+   }
+   Task = nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "wave_kernel_cpu.h"
+
+#include <immintrin.h>
+
+void updateWaveRowAVX2(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+)
+{
+   const __m256 two = _mm256_set1_ps( 2.0f );
+   const __m256 factor = _mm256_set1_ps( wave_factor );
+   const __m256 denominator = _mm256_set1_ps( 1.0f + 4.0f * wave_factor );
+
+   int i = 0;
+   for (; i + 8 <= count; i += 8) {
+      __m256 updated_height = _mm256_sub_ps( _mm256_mul_ps( two, _mm256_loadu_ps( curr + i ) ), _mm256_loadu_ps( prev + i ) );
+      updated_height = _mm256_add_ps( updated_height, _mm256_mul_ps( factor, _mm256_loadu_ps( curr + i - 1 ) ) );
+      updated_height = _mm256_add_ps( updated_height, _mm256_mul_ps( factor, _mm256_loadu_ps( curr + i + 1 ) ) );
+      if (curr_up != nullptr) {
+         updated_height = _mm256_add_ps( updated_height, _mm256_mul_ps( factor, _mm256_loadu_ps( curr_up + i ) ) );
+      }
+      if (curr_down != nullptr) {
+         updated_height = _mm256_add_ps( updated_height, _mm256_mul_ps( factor, _mm256_loadu_ps( curr_down + i ) ) );
+      }
+      _mm256_storeu_ps( next + i, _mm256_div_ps( updated_height, denominator ) );
+   }
+
+   if (i < count) {
+      updateWaveRowScalar(
+         next + i, prev + i, curr + i,
+         curr_up != nullptr ? curr_up + i : nullptr,
+         curr_down != nullptr ? curr_down + i : nullptr,
+         count - i, wave_factor
+      );
+   }
+}
\ No newline at end of file
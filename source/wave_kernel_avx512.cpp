@@ -0,0 +1,50 @@
+#include "wave_kernel_cpu.h"
+
+#include <immintrin.h>
+
+void updateWaveRowAVX512(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+)
+{
+   const __m512 two = _mm512_set1_ps( 2.0f );
+   const __m512 factor = _mm512_set1_ps( wave_factor );
+   const __m512 denominator = _mm512_set1_ps( 1.0f + 4.0f * wave_factor );
+
+   int i = 0;
+   for (; i + 16 <= count; i += 16) {
+      __m512 updated_height = _mm512_sub_ps( _mm512_mul_ps( two, _mm512_loadu_ps( curr + i ) ), _mm512_loadu_ps( prev + i ) );
+      updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_loadu_ps( curr + i - 1 ) ) );
+      updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_loadu_ps( curr + i + 1 ) ) );
+      if (curr_up != nullptr) {
+         updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_loadu_ps( curr_up + i ) ) );
+      }
+      if (curr_down != nullptr) {
+         updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_loadu_ps( curr_down + i ) ) );
+      }
+      _mm512_storeu_ps( next + i, _mm512_div_ps( updated_height, denominator ) );
+   }
+
+   if (i < count) {
+      // masked-off lanes are neither loaded nor stored, so the tail never reads past the row
+      const auto mask = static_cast<__mmask16>((1u << (count - i)) - 1u);
+      __m512 updated_height = _mm512_sub_ps(
+         _mm512_mul_ps( two, _mm512_maskz_loadu_ps( mask, curr + i ) ),
+         _mm512_maskz_loadu_ps( mask, prev + i )
+      );
+      updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_maskz_loadu_ps( mask, curr + i - 1 ) ) );
+      updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_maskz_loadu_ps( mask, curr + i + 1 ) ) );
+      if (curr_up != nullptr) {
+         updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_maskz_loadu_ps( mask, curr_up + i ) ) );
+      }
+      if (curr_down != nullptr) {
+         updated_height = _mm512_add_ps( updated_height, _mm512_mul_ps( factor, _mm512_maskz_loadu_ps( mask, curr_down + i ) ) );
+      }
+      _mm512_mask_storeu_ps( next + i, mask, _mm512_div_ps( updated_height, denominator ) );
+   }
+}
\ No newline at end of file
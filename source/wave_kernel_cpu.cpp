@@ -0,0 +1,113 @@
+#include "wave_kernel_cpu.h"
+
+#ifdef WAVE_KERNEL_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+void updateWaveRowScalar(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+)
+{
+   const float denominator = 1.0f + 4.0f * wave_factor;
+   for (int i = 0; i < count; ++i) {
+      float updated_height = 2.0f * curr[i] - prev[i];
+      updated_height += wave_factor * curr[i - 1];
+      updated_height += wave_factor * curr[i + 1];
+      if (curr_up != nullptr) updated_height += wave_factor * curr_up[i];
+      if (curr_down != nullptr) updated_height += wave_factor * curr_down[i];
+      next[i] = updated_height / denominator;
+   }
+}
+
+#ifdef WAVE_KERNEL_X86
+#ifdef _MSC_VER
+namespace
+{
+   bool hasCPUFeature(int leaf, int subleaf, int register_index, int bit)
+   {
+      int info[4];
+      __cpuid( info, 0 );
+      if (info[0] < leaf) return false;
+      __cpuidex( info, leaf, subleaf );
+      return (info[register_index] & (1 << bit)) != 0;
+   }
+
+   bool isOSSavingRegisters(unsigned long long mask)
+   {
+      if (!hasCPUFeature( 1, 0, 2, 27 )) return false; // OSXSAVE
+      return (_xgetbv( 0 ) & mask) == mask;
+   }
+}
+#endif
+#endif
+
+bool isWaveKernelISASupported(WaveKernelISA isa)
+{
+#ifdef WAVE_KERNEL_X86
+#ifdef _MSC_VER
+   switch (isa) {
+      case WaveKernelISA::Scalar: return true;
+      case WaveKernelISA::SSE42: return hasCPUFeature( 1, 0, 2, 20 );
+      case WaveKernelISA::AVX2: return hasCPUFeature( 7, 0, 1, 5 ) && isOSSavingRegisters( 0x6 );
+      case WaveKernelISA::AVX512: return hasCPUFeature( 7, 0, 1, 16 ) && isOSSavingRegisters( 0xe6 );
+      default: return false;
+   }
+#else
+   __builtin_cpu_init();
+   switch (isa) {
+      case WaveKernelISA::Scalar: return true;
+      case WaveKernelISA::SSE42: return __builtin_cpu_supports( "sse4.2" );
+      case WaveKernelISA::AVX2: return __builtin_cpu_supports( "avx2" );
+      case WaveKernelISA::AVX512: return __builtin_cpu_supports( "avx512f" );
+      default: return false;
+   }
+#endif
+#else
+   return isa == WaveKernelISA::Scalar;
+#endif
+}
+
+WaveKernelISA getBestSupportedWaveKernelISA()
+{
+   static const WaveKernelISA best_isa = []() {
+      for (const auto isa : { WaveKernelISA::AVX512, WaveKernelISA::AVX2, WaveKernelISA::SSE42 }) {
+         if (isWaveKernelISASupported( isa )) return isa;
+      }
+      return WaveKernelISA::Scalar;
+   }();
+   return best_isa;
+}
+
+WaveRowKernel getWaveRowKernel(WaveKernelISA isa)
+{
+#ifdef WAVE_KERNEL_X86
+   switch (isa) {
+      case WaveKernelISA::SSE42: return updateWaveRowSSE42;
+      case WaveKernelISA::AVX2: return updateWaveRowAVX2;
+      case WaveKernelISA::AVX512: return updateWaveRowAVX512;
+      default: return updateWaveRowScalar;
+   }
+#else
+   return updateWaveRowScalar;
+#endif
+}
+
+std::string getWaveKernelISAString(WaveKernelISA isa)
+{
+   switch (isa) {
+      case WaveKernelISA::Scalar: return "Scalar";
+      case WaveKernelISA::SSE42: return "SSE4.2";
+      case WaveKernelISA::AVX2: return "AVX2";
+      case WaveKernelISA::AVX512: return "AVX-512";
+      default: return "";
+   }
+}
\ No newline at end of file
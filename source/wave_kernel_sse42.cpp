@@ -0,0 +1,41 @@
+#include "wave_kernel_cpu.h"
+
+#include <immintrin.h>
+
+void updateWaveRowSSE42(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int count,
+   float wave_factor
+)
+{
+   const __m128 two = _mm_set1_ps( 2.0f );
+   const __m128 factor = _mm_set1_ps( wave_factor );
+   const __m128 denominator = _mm_set1_ps( 1.0f + 4.0f * wave_factor );
+
+   int i = 0;
+   for (; i + 4 <= count; i += 4) {
+      __m128 updated_height = _mm_sub_ps( _mm_mul_ps( two, _mm_loadu_ps( curr + i ) ), _mm_loadu_ps( prev + i ) );
+      updated_height = _mm_add_ps( updated_height, _mm_mul_ps( factor, _mm_loadu_ps( curr + i - 1 ) ) );
+      updated_height = _mm_add_ps( updated_height, _mm_mul_ps( factor, _mm_loadu_ps( curr + i + 1 ) ) );
+      if (curr_up != nullptr) {
+         updated_height = _mm_add_ps( updated_height, _mm_mul_ps( factor, _mm_loadu_ps( curr_up + i ) ) );
+      }
+      if (curr_down != nullptr) {
+         updated_height = _mm_add_ps( updated_height, _mm_mul_ps( factor, _mm_loadu_ps( curr_down + i ) ) );
+      }
+      _mm_storeu_ps( next + i, _mm_div_ps( updated_height, denominator ) );
+   }
+
+   if (i < count) {
+      updateWaveRowScalar(
+         next + i, prev + i, curr + i,
+         curr_up != nullptr ? curr_up + i : nullptr,
+         curr_down != nullptr ? curr_down + i : nullptr,
+         count - i, wave_factor
+      );
+   }
+}
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include "wave_solver_cpu.h"
+
+WaveSolverCPU::WaveSolverCPU() :
+   KernelISA( getBestSupportedWaveKernelISA() ), RowKernel( getWaveRowKernel( KernelISA ) ), TargetIndex( 0 ),
+   BlockStepNum( 1 ), TileSize( 0 ), WaveFactor( 0.0f ), WavePointNumSize( 0, 0 ), WaveGridStep( 0.0f, 0.0f )
+{
+}
+
+void WaveSolverCPU::setKernelISA(WaveKernelISA isa)
+{
+   if (!isWaveKernelISASupported( isa )) {
+      std::cerr << getWaveKernelISAString( isa ) << " is not supported on this CPU, falling back to "
+         << getWaveKernelISAString( getBestSupportedWaveKernelISA() ) << "\n";
+      isa = getBestSupportedWaveKernelISA();
+   }
+   KernelISA = isa;
+   RowKernel = getWaveRowKernel( isa );
+}
+
+void WaveSolverCPU::setThreadNum(int thread_num, bool pin_threads)
+{
+   if (thread_num == 1) Pool.reset();
+   else Pool = std::make_unique<ThreadPool>( thread_num, pin_threads );
+}
+
+void WaveSolverCPU::setTemporalBlocking(int block_step_num, int tile_size)
+{
+   BlockStepNum = std::max( block_step_num, 1 );
+   TileSize = std::max( tile_size, 0 );
+   if (BlockStepNum == 1) {
+      for (auto& heights : SpareHeights) std::vector<float>().swap( heights );
+      TileScratches.clear();
+   }
+}
+
+glm::vec2 WaveSolverCPU::getWaveGridStep(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size)
+{
+   const float ds = 1.0f / static_cast<float>(wave_point_num_size.x - 1);
+   const float dt = 1.0f / static_cast<float>(wave_point_num_size.y - 1);
+   return { static_cast<float>(wave_grid_size.x) * ds, static_cast<float>(wave_grid_size.y) * dt };
+}
+
+float WaveSolverCPU::getWaveFactor(float grid_step, float delta_time)
+{
+   return WaveSpeed * WaveSpeed * delta_time * delta_time / grid_step;
+}
+
+float WaveSolverCPU::getInitialHeight(const glm::ivec2& wave_point_num_size, int x, int y)
+{
+   constexpr float initial_radius_squared = 81.0f;
+   constexpr float initial_wave_factor = glm::pi<float>() / initial_radius_squared;
+   constexpr float initial_wave_height = 0.5f;
+
+   const auto mid_x = static_cast<float>(wave_point_num_size.x >> 1);
+   const auto mid_y = static_cast<float>(wave_point_num_size.y >> 1);
+   const auto fx = static_cast<float>(x);
+   const auto fy = static_cast<float>(y);
+   const float distance_squared = (fx - mid_x) * (fx - mid_x) + (fy - mid_y) * (fy - mid_y);
+   if (distance_squared > initial_radius_squared) return 0.0f;
+
+   const float theta = std::sqrt( initial_wave_factor * distance_squared );
+   return initial_wave_height * (std::cos( theta ) + 1.0f);
+}
+
+void WaveSolverCPU::initialize(const glm::ivec2& wave_point_num_size, const glm::ivec2& wave_grid_size)
+{
+   TargetIndex = 0;
+   WavePointNumSize = wave_point_num_size;
+   WaveGridStep = getWaveGridStep( wave_point_num_size, wave_grid_size );
+   WaveFactor = getWaveFactor( WaveGridStep.x );
+
+   const auto size = static_cast<size_t>(wave_point_num_size.x) * wave_point_num_size.y;
+   Heights[0].resize( size );
+   for (int j = 0; j < wave_point_num_size.y; ++j) {
+      for (int i = 0; i < wave_point_num_size.x; ++i) {
+         Heights[0][j * wave_point_num_size.x + i] = getInitialHeight( wave_point_num_size, i, j );
+      }
+   }
+   Heights[1] = Heights[0];
+   Heights[2].assign( size, 0.0f );
+   Normals.assign( size, glm::vec3(0.0f) );
+}
+
+void WaveSolverCPU::updateWaveRow(
+   float* next,
+   const float* prev,
+   const float* curr,
+   const float* curr_up,
+   const float* curr_down,
+   int begin,
+   int end
+) const
+{
+   // The pointers address the column begin of their rows. The boundary columns lack a left or right neighbour,
+   // so they are updated here like wave.comp does, and the row kernel takes the interior cells.
+   const int width = WavePointNumSize.x;
+   const auto update_boundary = [&](int x) {
+      const int i = x - begin;
+      float updated_height = 2.0f * curr[i] - prev[i];
+      if (x > 0) updated_height += WaveFactor * curr[i - 1];
+      if (x < width - 1) updated_height += WaveFactor * curr[i + 1];
+      if (curr_up != nullptr) updated_height += WaveFactor * curr_up[i];
+      if (curr_down != nullptr) updated_height += WaveFactor * curr_down[i];
+      next[i] = updated_height / (1.0f + 4.0f * WaveFactor);
+   };
+
+   const int interior_begin = std::max( begin, 1 );
+   const int interior_end = std::min( end, width - 1 );
+   if (begin == 0) update_boundary( 0 );
+   if (interior_begin < interior_end) {
+      const int i = interior_begin - begin;
+      RowKernel(
+         next + i, prev + i, curr + i,
+         curr_up != nullptr ? curr_up + i : nullptr,
+         curr_down != nullptr ? curr_down + i : nullptr,
+         interior_end - interior_begin, WaveFactor
+      );
+   }
+   if (end == width && width > 1) update_boundary( width - 1 );
+}
+
+void WaveSolverCPU::runInRowBands(const std::function<void(int, int)>& task) const
+{
+   if (Pool == nullptr) {
+      task( 0, WavePointNumSize.y );
+      return;
+   }
+
+   const int band_num = Pool->getThreadNum();
+   Pool->run(
+      [&](int thread_index) {
+         const int begin = WavePointNumSize.y * thread_index / band_num;
+         const int end = WavePointNumSize.y * (thread_index + 1) / band_num;
+         if (begin < end) task( begin, end );
+      }
+   );
+}
+
+void WaveSolverCPU::updateWaveRows(int begin, int end)
+{
+   const float* prev = Heights[TargetIndex].data();
+   const float* curr = Heights[(TargetIndex + 1) % 3].data();
+   float* next = Heights[(TargetIndex + 2) % 3].data();
+
+   const int width = WavePointNumSize.x;
+   for (int y = begin; y < end; ++y) {
+      const size_t offset = static_cast<size_t>(y) * width;
+      updateWaveRow(
+         next + offset, prev + offset, curr + offset,
+         y > 0 ? curr + offset - width : nullptr,
+         y < WavePointNumSize.y - 1 ? curr + offset + width : nullptr,
+         0, width
+      );
+   }
+}
+
+void WaveSolverCPU::updateWave()
+{
+   runInRowBands( [this](int begin, int end) { updateWaveRows( begin, end ); } );
+}
+
+void WaveSolverCPU::estimateNormalRows(int begin, int end)
+{
+   // This is wave_normal.comp evaluated on the time level that updateWave() has just written.
+   const int width = WavePointNumSize.x;
+   const int height = WavePointNumSize.y;
+   const std::vector<float>& heights = Heights[(TargetIndex + 2) % 3];
+   const auto point = [&](int x, int y) {
+      return glm::vec3(
+         static_cast<float>(x) * WaveGridStep.x,
+         heights[y * width + x],
+         static_cast<float>(y) * WaveGridStep.y
+      );
+   };
+
+   for (int y = begin; y < end; ++y) {
+      for (int x = 0; x < width; ++x) {
+         glm::vec3 estimated_normal(0.0f);
+         const glm::vec3 point_vec = point( x, y );
+
+         if (y > 0) {
+            const glm::vec3 top_vec = point( x, y - 1 ) - point_vec;
+            if (x > 0) {
+               const glm::vec3 left_vec = point( x - 1, y ) - point_vec;
+               const glm::vec3 top_left_vec = point( x - 1, y - 1 ) - point_vec;
+               estimated_normal += glm::cross( top_vec, top_left_vec );
+               estimated_normal += glm::cross( top_left_vec, left_vec );
+            }
+            if (x < width - 1) {
+               const glm::vec3 right_vec = point( x + 1, y ) - point_vec;
+               const glm::vec3 top_right_vec = point( x + 1, y - 1 ) - point_vec;
+               estimated_normal += glm::cross( right_vec, top_right_vec );
+               estimated_normal += glm::cross( top_right_vec, top_vec );
+            }
+         }
+
+         if (y < height - 1) {
+            const glm::vec3 bottom_vec = point( x, y + 1 ) - point_vec;
+            if (x > 0) {
+               const glm::vec3 left_vec = point( x - 1, y ) - point_vec;
+               const glm::vec3 bottom_left_vec = point( x - 1, y + 1 ) - point_vec;
+               estimated_normal += glm::cross( left_vec, bottom_left_vec );
+               estimated_normal += glm::cross( bottom_left_vec, bottom_vec );
+            }
+            if (x < width - 1) {
+               const glm::vec3 right_vec = point( x + 1, y ) - point_vec;
+               const glm::vec3 bottom_right_vec = point( x + 1, y + 1 ) - point_vec;
+               estimated_normal += glm::cross( bottom_vec, bottom_right_vec );
+               estimated_normal += glm::cross( bottom_right_vec, right_vec );
+            }
+         }
+
+         Normals[y * width + x] = glm::normalize( estimated_normal );
+      }
+   }
+}
+
+void WaveSolverCPU::estimateNormals()
+{
+   runInRowBands( [this](int begin, int end) { estimateNormalRows( begin, end ); } );
+}
+
+int WaveSolverCPU::getTileSize(int block_step_num) const
+{
+   if (TileSize > 0) return TileSize;
+
+   // the extended tile, (tile size + 2 * block_step_num)^2 cells of three levels, should fit in TileCacheBytes.
+   const auto extended_size = static_cast<int>(std::sqrt( static_cast<double>(TileCacheBytes / (3 * sizeof( float ))) ));
+   return std::max( extended_size - 2 * block_step_num, 2 * block_step_num );
+}
+
+void WaveSolverCPU::advanceTile(
+   int block_step_num,
+   const glm::ivec2& tile_min,
+   const glm::ivec2& tile_max,
+   int thread_index
+)
+{
+   // The tile is extended by block_step_num cells on each side which is not the grid boundary.
+   // Every step shrinks the valid region by one cell on those sides, so the tile itself is exact after the last step.
+   const glm::ivec2 extended_min = glm::max( tile_min - block_step_num, glm::ivec2(0) );
+   const glm::ivec2 extended_max = glm::min( tile_max + block_step_num, WavePointNumSize );
+   const glm::ivec2 extended_size = extended_max - extended_min;
+   const auto scratch_index = [](int level) { return (level + 1) % 3; };
+
+   auto& scratch = TileScratches[thread_index];
+   for (auto& level : scratch) level.resize( static_cast<size_t>(extended_size.x) * extended_size.y );
+
+   const int width = WavePointNumSize.x;
+   for (int level = -1; level <= 0; ++level) {
+      const std::vector<float>& heights = Heights[(TargetIndex + level + 1) % 3];
+      for (int y = extended_min.y; y < extended_max.y; ++y) {
+         std::copy(
+            heights.begin() + static_cast<size_t>(y) * width + extended_min.x,
+            heights.begin() + static_cast<size_t>(y) * width + extended_max.x,
+            scratch[scratch_index( level )].begin() + static_cast<size_t>(y - extended_min.y) * extended_size.x
+         );
+      }
+   }
+
+   for (int t = 1; t <= block_step_num; ++t) {
+      const float* prev = scratch[scratch_index( t - 2 )].data();
+      const float* curr = scratch[scratch_index( t - 1 )].data();
+      float* next = scratch[scratch_index( t )].data();
+      const int begin_x = extended_min.x == 0 ? 0 : extended_min.x + t;
+      const int end_x = extended_max.x == width ? width : extended_max.x - t;
+      const int begin_y = extended_min.y == 0 ? 0 : extended_min.y + t;
+      const int end_y = extended_max.y == WavePointNumSize.y ? WavePointNumSize.y : extended_max.y - t;
+      for (int y = begin_y; y < end_y; ++y) {
+         const size_t offset = static_cast<size_t>(y - extended_min.y) * extended_size.x + begin_x - extended_min.x;
+         updateWaveRow(
+            next + offset, prev + offset, curr + offset,
+            y > 0 ? curr + offset - extended_size.x : nullptr,
+            y < WavePointNumSize.y - 1 ? curr + offset + extended_size.x : nullptr,
+            begin_x, end_x
+         );
+      }
+   }
+
+   for (int level = block_step_num - 1; level <= block_step_num; ++level) {
+      const std::vector<float>& source = scratch[scratch_index( level )];
+      std::vector<float>& heights = SpareHeights[level - block_step_num + 1];
+      for (int y = tile_min.y; y < tile_max.y; ++y) {
+         const size_t offset = static_cast<size_t>(y - extended_min.y) * extended_size.x + tile_min.x - extended_min.x;
+         std::copy(
+            source.begin() + offset,
+            source.begin() + offset + (tile_max.x - tile_min.x),
+            heights.begin() + static_cast<size_t>(y) * width + tile_min.x
+         );
+      }
+   }
+}
+
+void WaveSolverCPU::advanceTemporalBlock(int block_step_num)
+{
+   const int tile_size = getTileSize( block_step_num );
+   const glm::ivec2 tile_num = (WavePointNumSize + tile_size - 1) / tile_size;
+   const int thread_num = getThreadNum();
+   if (static_cast<int>(TileScratches.size()) < thread_num) TileScratches.resize( thread_num );
+   for (auto& heights : SpareHeights) heights.resize( Heights[0].size() );
+
+   std::atomic<int> next_tile( 0 );
+   const auto advance_tiles = [&](int thread_index) {
+      for (int tile = next_tile++; tile < tile_num.x * tile_num.y; tile = next_tile++) {
+         const glm::ivec2 tile_min(tile % tile_num.x * tile_size, tile / tile_num.x * tile_size);
+         advanceTile( block_step_num, tile_min, glm::min( tile_min + tile_size, WavePointNumSize ), thread_index );
+      }
+   };
+   if (Pool == nullptr) advance_tiles( 0 );
+   else Pool->run( advance_tiles );
+
+   // SpareHeights hold the time levels n + k - 1 and n + k, which k ordinary steps would leave in
+   // Heights[(TargetIndex + k) % 3] and Heights[(TargetIndex + k + 1) % 3]. The remaining grid is the one the next step
+   // overwrites without reading it, so its stale contents do not matter.
+   for (int i = 0; i < 2; ++i) Heights[(TargetIndex + block_step_num + i) % 3].swap( SpareHeights[i] );
+   TargetIndex = (TargetIndex + block_step_num - 1) % 3;
+}
+
+void WaveSolverCPU::step()
+{
+   updateWave();
+   estimateNormals();
+   TargetIndex = (TargetIndex + 1) % 3;
+}
+
+void WaveSolverCPU::advanceHeights(int step_num)
+{
+   // The last time level is left in Heights[(TargetIndex + 2) % 3] without the final rotation,
+   // so that the normals can still be estimated for it.
+   while (step_num > 1 && BlockStepNum > 1) {
+      const int block_step_num = std::min( step_num, BlockStepNum );
+      advanceTemporalBlock( block_step_num );
+      step_num -= block_step_num;
+      if (step_num == 0) return;
+      TargetIndex = (TargetIndex + 1) % 3;
+   }
+   for (int i = 1; i < step_num; ++i) {
+      updateWave();
+      TargetIndex = (TargetIndex + 1) % 3;
+   }
+   updateWave();
+}
+
+void WaveSolverCPU::advance(int step_num)
+{
+   if (step_num <= 0) return;
+   advanceHeights( step_num );
+   TargetIndex = (TargetIndex + 1) % 3;
+}
+
+void WaveSolverCPU::step(int step_num)
+{
+   // The normals are only estimated for the last time level, with or without temporal blocking.
+   if (step_num <= 0) return;
+   advanceHeights( step_num );
+   estimateNormals();
+   TargetIndex = (TargetIndex + 1) % 3;
+}
\ No newline at end of file